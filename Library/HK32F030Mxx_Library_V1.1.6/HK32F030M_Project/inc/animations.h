@@ -24,6 +24,7 @@
 #include "status_leds_hw.h"
 
 #define SIGMA_DEFAULT 0.7f      // default sigma value
+#define SIGMA_MIN 0.1f          // narrowest scan, keeps |i - mu| / sigma in 32 bits
 #define SATURATION_DEFAULT 1.0f // full saturation
 #define LIGHTNESS_DEFAULT 0.5f  // half lightness
 #define LIGHTNESS_DEFAULT 0.5f  // half lightness
@@ -99,6 +100,72 @@ typedef enum
     BRIGHTNESS_MODE_SEQUENCE // Sequence of brightness values
 } brightness_mode_t;
 
+/**
+ * @brief Type of animation described by an animation_params_t block
+ */
+typedef enum
+{
+    ANIMATION_TYPE_FADE, // Fade to black (see fade_animation_setup)
+    ANIMATION_TYPE_SCAN, // Scan animation (see scan_animation_setup)
+    ANIMATION_TYPE_FILL, // Fill animation (see fill_animation_setup)
+    ANIMATION_TYPE_FIRE, // Fire animation, if enabled (see fire_animation_setup)
+    ANIMATION_TYPE_COUNT
+} animation_type_t;
+
+/**
+ * @brief Flags for animation_params_t
+ */
+#define ANIMATION_FLAG_NONE 0x00U
+#define ANIMATION_FLAG_PERSONAL_HUE 0x01U // Hue range is relative to the personal color
+#define ANIMATION_FLAG_HUE_WRAP 0x02U     // Wrap the hue range to [0, 360) instead of clamping
+#define ANIMATION_FLAG_PERSONAL_RGB 0x04U // Use the personal color instead of rgb
+#define ANIMATION_FLAG_FOLLOW_ROLL 0x08U  // Reverse fills when the board is rolled over
+
+/**
+ * @brief Live modulation bindings for animation_params_t
+ *
+ * The bound parameters follow the modulation level, which status_leds feeds
+ * from the RPM, or the duty cycle with ANIMATION_MOD_DUTY, while riding.
+ */
+#define ANIMATION_MOD_NONE 0x00U
+#define ANIMATION_MOD_SPEED 0x01U      // Movement and color cycle speed up
+#define ANIMATION_MOD_HUE 0x02U        // Hue shifts by up to 120 degrees
+#define ANIMATION_MOD_BRIGHTNESS 0x04U // Brightness rises from a quarter
+#define ANIMATION_MOD_DUTY 0x80U       // Follow the duty cycle instead of the RPM
+#define ANIMATION_MOD_TARGETS (ANIMATION_MOD_SPEED | ANIMATION_MOD_HUE | ANIMATION_MOD_BRIGHTNESS)
+#define ANIMATION_MOD_MASK (ANIMATION_MOD_TARGETS | ANIMATION_MOD_DUTY)
+
+#define ANIMATION_SIGMA_MIN 10U // SIGMA_MIN in the 0.01 LED units of animation_params_t
+
+/**
+ * @brief Compact description of an animation.
+ *
+ * Every selectable animation is one of these blocks, interpreted by a single
+ * engine that calls the matching setup function. The blocks use integers
+ * only and have no pointers, so they can be stored in EEPROM as well as in
+ * flash.
+ */
+typedef struct
+{
+    uint16_t period;              // Scan movement or fade period (ms)
+    uint16_t color_speed;         // Period of the hue animation (ms)
+    uint16_t brightness_speed;    // Period of the brightness animation (ms, fill only)
+    uint16_t brightness_sequence; // Pattern for BRIGHTNESS_MODE_SEQUENCE (fill only)
+    int16_t hue_min;              // Start of the hue range (degrees)
+    int16_t hue_max;              // End of the hue range (degrees)
+    uint8_t type;                 // animation_type_t
+    uint8_t flags;                // ANIMATION_FLAG_* bits
+    uint8_t mode;                 // scan_direction_t (scan) or fill_mode_t (fill)
+    uint8_t color_mode;           // color_mode_t
+    uint8_t brightness_mode;      // brightness_mode_t (fill only)
+    uint8_t scan_end;             // scan_end_t (scan only)
+    uint8_t sigma;                // Width of the scan (0.01 LEDs, scan only)
+    uint8_t brightness_min;       // Minimum brightness (0-255, fill only)
+    uint8_t brightness_max;       // Maximum brightness (0-255, fill only)
+    uint8_t modulation;           // ANIMATION_MOD_* bindings
+    status_leds_color_t rgb;      // Color for COLOR_MODE_RGB
+} animation_params_t;
+
 /**
  * @brief Callback function for animations.
  */
@@ -195,6 +262,31 @@ uint16_t fade_animation_setup(status_leds_color_t *buffer, uint16_t period,
 uint16_t fire_animation_setup(status_leds_color_t *buffer);
 #endif
 
+/**
+ * @brief Checks that an animation parameter block can be started.
+ *
+ * Blocks read from EEPROM are checked with this before use, so a corrupt or
+ * hand written block can not trip a fault in the setup functions.
+ *
+ * @param params Pointer to the parameter block to check.
+ *
+ * @return true if every field is in range, false otherwise.
+ */
+bool_t animation_params_valid(const animation_params_t *params);
+
+/**
+ * @brief Draws a static bar graph into a buffer.
+ *
+ * LEDs below the level are set to the color and the LED at the edge fades
+ * out the same way as a fill scan, so the bar can show fractions of an LED.
+ * The animation timer is not used.
+ *
+ * @param buffer The buffer to draw into, one entry per LED on the strip.
+ * @param level The end of the bar in LEDs (Q8.8), may be negative.
+ * @param color The color of the bar.
+ */
+void bar_fill(status_leds_color_t *buffer, int32_t level, const status_leds_color_t *color);
+
 /**
  * @brief Stop the current animation.
  *
@@ -203,6 +295,56 @@ uint16_t fire_animation_setup(status_leds_color_t *buffer);
  */
 void stop_animation(void);
 
+#ifdef ENABLE_STATUS_LEDS_BENCHMARK
+/**
+ * @brief Runs one frame of the current animation immediately.
+ *
+ * Used to time the animation kernels without waiting for the animation timer.
+ *
+ * @param tick The system tick passed to the animation.
+ */
+void animation_step(uint32_t tick);
+#endif
+
+/**
+ * @brief Binds the running animation to the live modulation.
+ *
+ * Bindings are cleared whenever a new animation starts, so this is called
+ * right after the setup function.
+ *
+ * @param targets ANIMATION_MOD_* targets to bind, other bits are ignored.
+ */
+void animation_modulate(uint8_t targets);
+
+/**
+ * @brief Sets the strength of the live modulation.
+ *
+ * Only stores the level, which is applied by the next frames of any
+ * animation bound to it.
+ *
+ * @param level Modulation strength, 0 (at rest) to 255 (full).
+ */
+void animation_set_modulation(uint8_t level);
+
+/**
+ * @brief Starts a crossfade between two displays.
+ *
+ * The crossfade is clocked by the animation timer, which is kept running
+ * until it completes even if no animation is. Each frame the opacity of the
+ * outgoing display drops and a refresh is requested, the blending itself is
+ * done by the status LEDs compositor.
+ *
+ * @param frames Number of frames the crossfade lasts, 0 cancels it.
+ */
+void animation_crossfade_start(uint8_t frames);
+
+/**
+ * @brief Gets the opacity of the outgoing display of the crossfade.
+ *
+ * @return 255 when the crossfade starts, dropping to 0 when it is complete.
+ */
+uint8_t animation_crossfade_alpha(void);
+
 /**
  * @brief Converts HSL color values to RGB color values.
  *
@@ -225,8 +367,9 @@ void hsl_to_rgb(float h, float s, float l, status_leds_color_t *color);
  * @brief Retrieves the ID of the current animation.
  * 
  * This function returns a 16-bit unsigned integer representing the unique
- * identifier of the currently active animation. The ID can be used to
- * identify or manage animations within the system.
+ * identifier of the most recently started animation, the same value its
+ * setup function returned. The ID can be used to check whether an animation
+ * has since been replaced.
  * 
  * @return uint16_t The ID of the current animation.
  */
@@ -37,6 +37,11 @@ typedef enum
     BOARD_MODE_FAULT        /**< Board has encountered a fault. */
 } board_mode_t;
 
+// Set of board modes, used by modules to declare the modes they are
+// interested in
+#define BOARD_MODE_MASK(mode) ((board_mode_mask_t)(1U << (mode)))
+typedef uint8_t board_mode_mask_t;
+
 /**
  * @enum board_submode_t
  * @brief Represents the various submodes within each operational mode.
@@ -42,8 +42,26 @@
 //------------------------------------------------------------------------------
 #define STOPPED_RPM_THRESHOLD 20           // RPM threshold for stopped
 #define SLOW_RPM_THRESHOLD 2000            // RPM threshold for slow riding speed (3-4 MPH)
-#define DUTY_CYCLE_DANGER_THRESHOLD 90.0f  // Duty cycle threshold for danger zone
-#define DUTY_CYCLE_WARNING_THRESHOLD 80.0f // Duty cycle threshold for warning zone
+#define DUTY_CYCLE_DANGER_THRESHOLD 900    // Duty cycle threshold for danger zone (0.1%)
+#define DUTY_CYCLE_WARNING_THRESHOLD 800   // Duty cycle threshold for warning zone (0.1%)
+#define ROLL_SET_THRESHOLD 4500            // Roll at which the board is on its side (0.01 deg)
+#define ROLL_RESET_THRESHOLD 4000          // Roll at which the board is upright again (0.01 deg)
+
+//------------------------------------------------------------------------------
+// Telemetry configuration
+//------------------------------------------------------------------------------
+// Telemetry from the VESC is polled several times a second, but most of the
+// time the values only jitter by a count or two.  A change event is only
+// raised when a value moves further than its deadband from the last reported
+// value, which keeps the event queue (and everything downstream of it) quiet.
+//
+// Deadbands are expressed in the same fixed-point units the values are
+// reported in (see vesc_telemetry_t).
+#define TELEMETRY_DUTY_CYCLE_DEADBAND 5    // Duty cycle deadband (0.1%)
+#define TELEMETRY_RPM_DEADBAND 5           // RPM deadband (ERPM)
+#define TELEMETRY_VOLTAGE_DEADBAND 1       // Input voltage deadband (0.1V)
+#define TELEMETRY_BATTERY_DEADBAND 5       // Battery level deadband (0.1%)
+#define TELEMETRY_IMU_ANGLE_DEADBAND 100   // IMU pitch/roll deadband (0.01 deg)
 
 //------------------------------------------------------------------------------
 // Button configuration 
@@ -66,8 +84,18 @@
 #define SLOW_BREATH_PERIOD 6000U            // How fast to "breathe" headlights when dozing (ms)
 #define FAST_BREATH_PERIOD 500U             // How fast to flash headlights (ms)
 #define FADE_PERIOD 500U                    // How long to fade out headlights on disable (ms) 
-#define RPM_HYSTERISIS 40.0f                // How many ERPMs (+/-) to allow before changing direction
+#define RPM_HYSTERISIS 40                   // How many ERPMs (+/-) to allow before changing direction
+#define ENABLE_HEADLIGHTS_CIE 1             // Perceptual (CIE lightness) headlight brightness
+#ifdef ENABLE_HEADLIGHTS_CIE
+#define HEADLIGHTS_IDLE_BRIGHTNESS 0.50f    // Brightness of headlights when idle (0.0 to 1.0) 
+#define HEADLIGHTS_DOZING_BRIGHTNESS 0.25f  // Dimmest point of the dozing breath (0.0 to 1.0)
+#else
 #define HEADLIGHTS_IDLE_BRIGHTNESS 0.20f    // Brightness of headlights when idle (0.0 to 1.0) 
+#define HEADLIGHTS_DOZING_BRIGHTNESS 0.05f  // Dimmest point of the dozing breath (0.0 to 1.0)
+#endif
+#define ENABLE_HEADLIGHTS_HIRES_PWM 1       // 15 bit headlight PWM instead of 10 bit
+#undef ENABLE_HEADLIGHTS_DITHER             // Dither the headlight PWM for 4 more bits
+#undef ENABLE_HEADLIGHTS_BENCHMARK          // Measure the headlight dither interrupt load
 
 //------------------------------------------------------------------------------
 // Status LED configuration 
@@ -79,9 +107,31 @@
 // board like an XR.
 #define ENABLE_STATUS_LEDS 1                      // Enable the status LEDs
 #define STATUS_LEDS_FADE_TO_BLACK_TIMEOUT (1000U) // Time to fade to black when shutting down
-#define LOW_BATTERY_THRESHOLD (15.0f)             // Threshold for yellow/always on indicator
-#define CRITICAL_BATTERY_THRESHOLD (5.0f)         // Threshold for red flashing indicator
+#define LOW_BATTERY_THRESHOLD (150)               // Threshold for yellow/always on indicator (0.1%)
+#define CRITICAL_BATTERY_THRESHOLD (50)           // Threshold for red flashing indicator (0.1%)
 #define STATUS_LEDS_SCAN_SPEED (2000U)            // Speed of the scan animation (ms)
+#define STATUS_LEDS_MOD_RPM_FULL (10000)          // ERPM for full animation modulation
+#define STATUS_LEDS_MOD_DUTY_FULL (800)           // Duty cycle (0.1%) for full animation modulation
+#define STATUS_LEDS_CROSSFADE_FRAMES (12U)        // Frames to crossfade between modes, 0 to cut
+#define ENABLE_STATUS_LEDS_GAMMA 1                // Gamma correct and dither the LED output
+
+// The number of LEDs on each strip is set in the settings. Every LED costs
+// about 25 bytes of RAM for the layers and frame buffers, so the buffers are
+// sized for the longest strip the build supports.
+#define STATUS_LEDS_MAX_COUNT (10U) // Most LEDs on all strips together
+#define STATUS_LEDS_MAX_STRIPS (2U) // Strips chained on the data line
+#undef ENABLE_STATUS_LEDS_RGBW      // Support RGBW strips, 2 more bytes of RAM per LED
+
+// Time a frame for every strip length up to STATUS_LEDS_MAX_COUNT at boot and
+// leave the results in status_leds_benchmark_us for the debugger.
+#undef ENABLE_STATUS_LEDS_BENCHMARK // Measure the frame time against the LED count
+
+// By default the LED data is bit-banged one LED at a time, with interrupts
+// disabled only while an LED is sent and re-enabled between LEDs. On boards
+// where the data line can be mapped to SPI1 MOSI the frame can be sent by the
+// SPI peripheral instead, fed from its interrupt, which leaves SysTick and the
+// VESC UART running during the whole update.
+#undef ENABLE_STATUS_LEDS_SPI // Send the LED data with SPI1 instead of bit-banging
 
 //------------------------------------------------------------------------------
 // Animation configuration 
@@ -96,6 +146,12 @@
 #undef ENABLE_PULSE_ANIMATION           // Expanding pulse animation 
 #undef ENABLE_THE_FUZZ_ANIMATION        // The Fuzz animation 
 
+// Animations are described by small parameter blocks (see animation_params_t),
+// so each built-in animation costs a table entry rather than code. Custom
+// animations use the same format and live in the settings in EEPROM, so they
+// can be changed without reflashing.
+#define ENABLE_CUSTOM_ANIMATIONS 1 // Selectable custom animation slots
+
 //------------------------------------------------------------------------------
 // Buzzer configuration 
 //------------------------------------------------------------------------------
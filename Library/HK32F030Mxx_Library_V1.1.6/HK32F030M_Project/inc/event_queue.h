@@ -25,6 +25,7 @@
 #include "command_processor.h"
 #include "footpads.h"
 #include "lcm_types.h"
+#include "vesc_serial.h"
 
 #define EVENT_HANDLER_NAME(module, e) module##_##e##_event_handler
 #define EVENT_HANDLER(module, e)                                                                   \
@@ -74,15 +75,8 @@ typedef enum
     EVENT_SERIAL_DATA_RX,
 
     // VESC events
-    EVENT_DUTY_CYCLE_CHANGED,
-    EVENT_RPM_CHANGED,
-    EVENT_VOLTAGE_CHANGED,
-    EVENT_BATTERY_LEVEL_CHANGED,
+    EVENT_TELEMETRY_UPDATED,
     EVENT_VESC_ALIVE,
-    
-    // IMU events
-    EVENT_IMU_PITCH_CHANGED,
-    EVENT_IMU_ROLL_CHANGED,
 
     // Command events
     EVENT_COMMAND_CONTEXT_CHANGED,
@@ -95,7 +89,6 @@ typedef enum
     EVENT_COMMAND_SETTINGS_CHANGED,
     EVENT_COMMAND_MODE_CONFIG,
     EVENT_EMERGENCY_FAULT,
-    EVENT_VESC_FAULT_CHANGED,
 
     // Must be last
     NUMBER_OF_EVENTS
@@ -134,16 +127,10 @@ typedef union {
     footpads_state_t footpads_state;
     emergency_fault_t emergency_fault;
     button_event_data_t button_data;
-    float32_t duty_cycle;
-    int32_t rpm;
-    float32_t voltage;
-    float32_t battery_level;
-    uint8_t vesc_fault;
+    telemetry_fields_t telemetry_changed;
     uint8_t click_count;
     command_processor_context_t context;
     bool_t enable;
-    float32_t imu_pitch;
-    float32_t imu_roll;
 } event_data_t;
 
 /**
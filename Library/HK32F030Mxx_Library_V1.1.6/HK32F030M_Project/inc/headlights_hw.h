@@ -23,7 +23,11 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-#define HEADLIGHTS_HW_MAX_BRIGHTNESS TIM1_PERIOD
+/**
+ * @brief Full brightness, on a linear scale that the hardware maps onto the
+ * TIM1 period
+ */
+#define HEADLIGHTS_HW_MAX_BRIGHTNESS (4096U)
 
 /**
  * @brief Headlights direction
@@ -77,4 +81,21 @@ headlights_direction_t headlights_hw_get_direction(void);
  */
 void headlights_hw_set_brightness(uint16_t brightness);
 
+/**
+ * @brief Returns the brightness level that headlights_hw_set_brightness maps
+ * onto a given duty cycle.
+ *
+ * This is the inverse of the CIE lightness curve when it is enabled, and the
+ * duty cycle itself otherwise.
+ *
+ * @param duty The duty cycle, ranging from 0 to HEADLIGHTS_HW_MAX_BRIGHTNESS.
+ * @return The brightness level, ranging from 0 to HEADLIGHTS_HW_MAX_BRIGHTNESS.
+ */
+uint16_t headlights_hw_lightness(uint16_t duty);
+
+/**
+ * @brief TIM1 update interrupt handler, dithers the headlight PWM.
+ */
+void headlights_hw_tim1_irq(void);
+
 #endif
\ No newline at end of file
@@ -22,6 +22,7 @@
 #include <stdint.h>
 #include "lcm_types.h"
 #include "status_leds.h"
+#include "animations.h"
 
 /**
  * @brief Structure to hold the settings for the device.
@@ -29,7 +30,7 @@
 typedef struct
 {
     uint32_t magic;                        // Magic number to identify valid settings.
-    float32_t headlight_brightness;        // Brightness level for the headlights
+    float32_t headlight_brightness;        // Headlight duty cycle at full brightness (0.0 to 1.0)
     float32_t status_brightness;           // Brightness level for the status LEDs.
     float32_t personal_color;              // Personal color.
     bool_t enable_beep;                    // Flag to enable or disable beep sound.
@@ -40,6 +41,10 @@ typedef struct
     animation_option_t dozing_animation;   // Animation option for dozing state.
     animation_option_t shutdown_animation; // Animation option for shutdown sequence.
     animation_option_t ride_animation;     // Animation option for riding state.
+    status_leds_strip_t status_leds_strips[STATUS_LEDS_MAX_STRIPS]; // Status LED strips fitted.
+#ifdef ENABLE_CUSTOM_ANIMATIONS
+    animation_params_t custom_animations[CUSTOM_ANIMATION_COUNT]; // User defined animations.
+#endif
 } settings_t;
 
 /**
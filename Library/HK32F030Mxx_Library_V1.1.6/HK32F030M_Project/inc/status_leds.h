@@ -52,9 +52,21 @@ typedef enum
     ANIMATION_OPTION_COMPLEMENTARY_WAVE,
     ANIMATION_OPTION_FLOATWHEEL_CLASSIC,
     ANIMATION_OPTION_PERSONAL_SCAN,
+    // User defined animations, stored in EEPROM
+#ifdef ENABLE_CUSTOM_ANIMATIONS
+    ANIMATION_OPTION_CUSTOM_1,
+    ANIMATION_OPTION_CUSTOM_2,
+#endif
     ANIMATION_OPTION_COUNT
 } animation_option_t;
 
+#ifdef ENABLE_CUSTOM_ANIMATIONS
+/**
+ * @brief Number of user defined animation slots in the settings
+ */
+#define CUSTOM_ANIMATION_COUNT (ANIMATION_OPTION_COUNT - ANIMATION_OPTION_CUSTOM_1)
+#endif
+
 /**
  * @brief Initializes the status LEDs
  *
@@ -74,9 +86,35 @@ lcm_status_t status_leds_init(void);
  */
 lcm_status_t status_leds_set_color(const status_leds_color_t *color, uint8_t begin, uint8_t end);
 
+/**
+ * @brief Returns the total number of LEDs on a set of chained strips.
+ *
+ * @param strips STATUS_LEDS_MAX_STRIPS strip descriptors, as in the settings.
+ * @return uint8_t The number of LEDs, or 0 if they do not fit STATUS_LEDS_MAX_COUNT.
+ */
+uint8_t status_leds_strips_count(const status_leds_strip_t *strips);
+
+/**
+ * @brief Returns the number of status LEDs, on all strips together.
+ */
+uint8_t status_leds_get_count(void);
+
+/**
+ * @brief Starts a built-in or custom animation on the status LEDs.
+ *
+ * @param option The animation to start.
+ * @return uint16_t ID of the started animation, 0 if none.
+ */
+uint16_t status_leds_start_animation_option(animation_option_t option);
+
 /**
  * @brief Refreshes the status LEDs display.
  */
 lcm_status_t status_leds_refresh(void);
 
+/**
+ * @brief Sends a pending refresh to the hardware if the frame has changed.
+ */
+void status_leds_flush(void);
+
 #endif
\ No newline at end of file
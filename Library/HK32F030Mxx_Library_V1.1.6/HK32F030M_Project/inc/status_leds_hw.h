@@ -21,13 +21,14 @@
 
 #include <stdint.h>
 #include "lcm_types.h"
-
-#define STATUS_LEDS_COUNT 10U
+#include "config.h"
 
 /**
  * @brief Status LED color struct.
  *
- * This struct is used to represent the color of a single status LED.
+ * This struct is used to represent the color of a single status LED. Colors
+ * are always RGB, the channel order of the strip is applied when the frame is
+ * sent.
  *
  * @struct status_leds_color_t
  * @var r     The red component of the color (0-255)
@@ -36,14 +37,60 @@
  */
 typedef struct
 {
-    uint8_t g;
     uint8_t r;
+    uint8_t g;
     uint8_t b;
 } status_leds_color_t;
 
-void status_leds_hw_init(const status_leds_color_t *buffer);
-void status_leds_hw_refresh(void);
+/**
+ * @brief Order the channels of a LED are sent in, W being a white channel
+ */
+typedef enum
+{
+    STATUS_LEDS_ORDER_GRB, // WS2812B
+    STATUS_LEDS_ORDER_RGB, // WS2811 and some clones
+    STATUS_LEDS_ORDER_BRG,
+    STATUS_LEDS_ORDER_RBG,
+    STATUS_LEDS_ORDER_GBR,
+    STATUS_LEDS_ORDER_BGR,
+#ifdef ENABLE_STATUS_LEDS_RGBW
+    STATUS_LEDS_ORDER_GRBW, // SK6812 RGBW
+    STATUS_LEDS_ORDER_RGBW,
+#endif
+    STATUS_LEDS_ORDER_COUNT
+} status_leds_order_t;
+
+#ifdef ENABLE_STATUS_LEDS_RGBW
+#define STATUS_LEDS_MAX_CHANNELS 4U
+#else
+#define STATUS_LEDS_MAX_CHANNELS 3U
+#endif
+
+/**
+ * @brief Status LED strip descriptor.
+ *
+ * The strips are chained on the one data line in the order they are listed,
+ * so the first LED of a strip follows the last LED of the strip before it.
+ *
+ * @struct status_leds_strip_t
+ * @var count Number of LEDs on the strip, 0 if it is not fitted
+ * @var order Channel order of the LEDs (status_leds_order_t)
+ */
+typedef struct
+{
+    uint8_t count;
+    uint8_t order;
+} status_leds_strip_t;
+
+void status_leds_hw_init(void);
+void status_leds_hw_refresh(const status_leds_color_t *frame);
+bool_t status_leds_hw_busy(void);
+void status_leds_hw_set_strips(const status_leds_strip_t *strips);
 void status_leds_hw_set_brightness(float32_t brightness);
 void status_leds_hw_enable(bool_t enable);
+void status_leds_hw_spi_irq(void);
+#ifdef ENABLE_STATUS_LEDS_BENCHMARK
+uint32_t status_leds_hw_micros(void);
+#endif
 
 #endif
\ No newline at end of file
@@ -20,9 +20,16 @@
 #define _TIM1_H_
 
 #include "lcm_types.h"
+#include "config.h"
 
-// TIM1 period
-#define TIM1_PERIOD (1024U) // 2^10 so this is evenly shifted
+// TIM1 prescaler and period, both give a PWM frequency of about 1 kHz
+#ifdef ENABLE_HEADLIGHTS_HIRES_PWM
+#define TIM1_PRESCALER (1U)     // Counts at the 32 MHz core clock
+#define TIM1_PERIOD (32768U)    // 2^15 so this is evenly shifted
+#else
+#define TIM1_PRESCALER (32U)    // Counts at 1 MHz
+#define TIM1_PERIOD (1024U)     // 2^10 so this is evenly shifted
+#endif
 
 lcm_status_t TIM1_init(void);
 
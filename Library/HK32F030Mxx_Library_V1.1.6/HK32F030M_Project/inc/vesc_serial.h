@@ -21,28 +21,74 @@
 
 #include "ring_buffer.h"
 #include "lcm_types.h"
+#include "board_mode.h"
 #include "config.h"
 
-/**
- * @brief VESC serial callback function type
- */
-typedef void (*vesc_serial_callback_t)(void);
+// Telemetry fields, used in the changed mask of EVENT_TELEMETRY_UPDATED
+#define TELEMETRY_NONE 0x00U
+#define TELEMETRY_DUTY_CYCLE 0x01U
+#define TELEMETRY_RPM 0x02U
+#define TELEMETRY_INPUT_VOLTAGE 0x04U
+#define TELEMETRY_BATTERY_LEVEL 0x08U
+#define TELEMETRY_FAULT 0x10U
+#define TELEMETRY_IMU_PITCH 0x20U
+#define TELEMETRY_IMU_ROLL 0x40U
+#define TELEMETRY_STALE 0x80U // The stale flag changed
 
-lcm_status_t vesc_serial_init(void);
-ring_buffer_t *vesc_serial_get_rx_buffer(void);
+typedef uint8_t telemetry_fields_t;
 
-// Getters for the VESC serial data
-float32_t vesc_serial_get_duty_cycle(void);
-int32_t vesc_serial_get_rpm(void);
+/**
+ * @brief Snapshot of the most recent telemetry reported by the VESC
+ *
+ * The snapshot is written once per decoded response and the sequence number
+ * is incremented each time, so readers always see a consistent set of values.
+ * Values only move when they leave their deadband (see config.h), so they
+ * always match what was last announced with EVENT_TELEMETRY_UPDATED.
+ *
+ * All values are kept in the fixed-point units the VESC sends them in, so
+ * no floating point is needed between the UART and the consumers.
+ *
+ * If the VESC stops responding, the last known values are kept but the
+ * snapshot is marked stale until the VESC answers again.
+ */
+typedef struct
+{
+    uint32_t sequence;     // Incremented for every decoded response
+    bool_t stale;          // Set while the VESC is not responding
+    int16_t duty_cycle;    // Duty cycle (0.1%, -1000 to 1000)
+    int32_t rpm;           // Electrical RPM
 #if defined(ENABLE_VOLTAGE_MONITORING)
-float32_t vesc_serial_get_input_voltage(void);
+    int16_t input_voltage; // Input voltage (0.1V)
 #endif
-float32_t vesc_serial_get_battery_level(void);
-uint8_t vesc_serial_get_fault(void);
-lcm_status_t vesc_serial_check_busy_and_set_callback(vesc_serial_callback_t callback);
+    int16_t battery_level; // Battery level (0.1%, 0 to 1000)
+    uint8_t fault;         // VESC fault code
 #if defined(ENABLE_IMU_EVENTS)
-float32_t vesc_serial_get_imu_pitch(void);
-float32_t vesc_serial_get_imu_roll(void);
+    int16_t imu_pitch;     // Pitch (0.01 degrees)
+    int16_t imu_roll;      // Roll (0.01 degrees)
 #endif
+} vesc_telemetry_t;
+
+lcm_status_t vesc_serial_init(void);
+ring_buffer_t *vesc_serial_get_rx_buffer(void);
+
+/**
+ * @brief Gets the current telemetry snapshot
+ *
+ * @return A pointer to the telemetry snapshot (never NULL)
+ */
+const vesc_telemetry_t *vesc_serial_get_telemetry(void);
+
+/**
+ * @brief Declares which telemetry fields a module needs in which board modes
+ *
+ * The basic values (duty cycle, RPM, battery level, etc.) are always polled.
+ * The IMU angles are only requested from the VESC while the board is in a
+ * mode that at least one module has declared a need for. Modules should
+ * declare their needs during initialization; declarations accumulate.
+ *
+ * @param fields The telemetry fields that are needed
+ * @param modes The board modes in which they are needed
+ */
+void vesc_serial_declare_demand(telemetry_fields_t fields, board_mode_mask_t modes);
 
 #endif
@@ -31,6 +31,108 @@
  */
 #define ANIMATION_DELAY 25U
 
+/**
+ * @brief Fixed-point one in Q8.8
+ *
+ * LED position (mu) and brightness are carried through the animation engine
+ * in Q8.8, and hue in hue wheel units, so that a frame never touches the
+ * soft-float library.
+ */
+#define Q8_ONE 256
+
+/**
+ * @brief Fixed-point one in Q15, used where Q8.8 would lose visible precision
+ */
+#define Q15_ONE 32768U
+
+/**
+ * @brief Length of one waveform period in phase units (2*PI)
+ */
+#define WAVE_PERIOD (1UL << 24)
+
+/**
+ * @brief Normalized waveform amplitude of 1.0 (Q14)
+ */
+#define WAVE_ONE 16384
+
+/**
+ * @brief Number of hue units in a 60 degree sector of the color wheel
+ *
+ * One hue unit moves one channel by one step, so a sector is 256 units.
+ */
+#define HUE_SECTOR 256
+
+/**
+ * @brief Number of hue units in the full color wheel
+ */
+#define HUE_WHEEL (6 * HUE_SECTOR)
+
+/**
+ * @brief Live modulation at full strength: speed multiplier, hue shift (120
+ * degrees) and the brightness the modulation starts from when at rest.
+ */
+#define MODULATION_SPEED_MAX 4U
+#define MODULATION_HUE_SHIFT (HUE_WHEEL / 3)
+#define MODULATION_BRIGHTNESS_MIN (Q8_ONE / 4)
+
+/**
+ * @brief Distance from mu, in sigmas, where the gaussian falls to 1% of its peak
+ *
+ * sqrt(-2 * ln(0.01)), used to start and end a scan just off the strip.
+ */
+#define GAUSSIAN_FALLOFF 3.0349f
+
+/**
+ * @brief Number of gaussian table steps per sigma
+ */
+#define GAUSSIAN_STEPS_PER_SIGMA 16U
+
+/**
+ * @brief Number of gaussian table steps, covering 0 to 4 sigma
+ */
+#define GAUSSIAN_STEPS 64U
+
+/**
+ * @brief Quarter sine wave, 64 steps from 0 to PI/2 (Q14)
+ */
+static const int16_t sine_quarter[65] = {
+    0,     402,   804,   1205,  1606,  2006,  2404,  2801,  3196,  3590,  3981,  4370,  4756,
+    5139,  5520,  5897,  6270,  6639,  7005,  7366,  7723,  8076,  8423,  8765,  9102,  9434,
+    9760,  10080, 10394, 10702, 11003, 11297, 11585, 11866, 12140, 12406, 12665, 12916, 13160,
+    13395, 13623, 13842, 14053, 14256, 14449, 14635, 14811, 14978, 15137, 15286, 15426, 15557,
+    15679, 15791, 15893, 15986, 16069, 16143, 16207, 16261, 16305, 16340, 16364, 16379, 16384};
+
+/**
+ * @brief Unit gaussian e^(-t^2 / 2) for t = 0 to 4 in 1/16 steps (Q15)
+ *
+ * Every gaussian is this one stretched by sigma, so a single table in flash
+ * serves any sigma and nothing has to be built at setup.
+ */
+static const uint16_t gaussian_kernel[GAUSSIAN_STEPS + 1] = {
+    32768, 32704, 32513, 32197, 31760, 31206, 30543, 29777, 28918, 27973, 26954, 25871, 24735,
+    23556, 22346, 21115, 19875, 18634, 17403, 16190, 15002, 13848, 12732, 11661, 10638, 9667,
+    8751,  7890,  7087,  6340,  5650,  5015,  4435,  3906,  3427,  2995,  2607,  2261,  1953,
+    1680,  1440,  1229,  1045,  885,   747,   628,   526,   438,   364,   301,   248,   204,
+    167,   136,   110,   89,    72,    57,    46,    37,    29,    23,    18,    14,    11};
+
+/**
+ * @brief Fixed-point waveform generator
+ *
+ * Integer counterpart of function_generator_t used by the animations. The
+ * phase runs from 0 to WAVE_PERIOD and the output is in Q8.8.
+ */
+typedef struct
+{
+    int32_t scale;      /*< Half of the output range (Q8.8) */
+    int32_t offset;     /*< Midpoint of the output range (Q8.8) */
+    uint32_t phase;     /*< Current phase (WAVE_PERIOD = 2*PI) */
+    uint32_t increment; /*< Phase increment per sample */
+    uint16_t sequence;  /*< 16-bit mask for sequence */
+    bool repeat;        /*< Whether wave repeats */
+    bool inverse;       /*< Whether to reverse the direction of the wave */
+    waveform_t type;    /*< Waveform type */
+} wave_t;
+
 /**
  * @brief Reusable structure to represent a color animation
  */
@@ -38,7 +140,7 @@ typedef struct
 {
     color_mode_t mode;              /*< Animation color mode*/
     const status_leds_color_t *rgb; /*< RGB color */
-    function_generator_t fg;        /*< Function generator for h */
+    wave_t wave;                    /*< Waveform for h */
 } color_animation_t;
 
 /**
@@ -46,9 +148,9 @@ typedef struct
  */
 typedef struct
 {
-    brightness_mode_t mode;  /*< Animation brightness mode*/
-    float static_value;      /*< Static brightness value */
-    function_generator_t fg; /*< Function generator for b */
+    brightness_mode_t mode; /*< Animation brightness mode*/
+    int32_t static_value;   /*< Static brightness value (Q8.8) */
+    wave_t wave;            /*< Waveform for b */
 } brightness_animation_t;
 
 /**
@@ -63,8 +165,8 @@ typedef struct
     status_leds_color_t *buffer; /*< LED buffer */
     color_animation_t color;     /*< Color animation */
     scan_direction_t direction;  /*< Scan direction */
-    float sigma;                 /*< Standard deviation */
-    function_generator_t fg;     /*< Function generator for mu */
+    uint32_t inv_sigma;          /*< 1 / sigma (Q12) */
+    wave_t wave;                 /*< Waveform for mu */
 } scan_animation_t;
 
 /**
@@ -101,7 +203,7 @@ typedef struct
 typedef struct
 {
     status_leds_color_t *buffer;
-    uint8_t heat[STATUS_LEDS_COUNT];
+    uint8_t heat[STATUS_LEDS_MAX_COUNT];
     uint8_t prng_state;
 } fire_animation_t;
 #endif
@@ -128,56 +230,313 @@ static animation_config_t animation_config = {0};
 static animation_tick_t timer_callback = NULL;
 static uint16_t animation_id = 0U; // Current animation ID
 
+// A crossfade shares the animation timer, so it costs no extra timer and its
+// frames line up with the animation frames
+static uint8_t crossfade_alpha = 0U; // Opacity of the outgoing frame
+static uint8_t crossfade_step = 0U;  // Opacity lost per frame
+
+// Live modulation of the running animation. The level is only stored when
+// telemetry arrives and applied while the frames are drawn, so the animation
+// never has to be set up again.
+static uint8_t modulation_targets = ANIMATION_MOD_NONE; // ANIMATION_MOD_* targets
+static uint8_t modulation_level = 0U;                   // Strength, 0 to 255
+
 // Each animation is implemented as a timer callback
 TIMER_CALLBACK(animation, tick);
 
+/**
+ * @brief Converts a float to Q8.8, rounding to the nearest step.
+ */
+static int32_t float_to_q8(float value)
+{
+    return (int32_t)(value * Q8_ONE + ((value >= 0.0f) ? 0.5f : -0.5f));
+}
+
+/**
+ * @brief Converts a hue in degrees to hue wheel units.
+ */
+static int32_t degrees_to_hue(float degrees)
+{
+    return (int32_t)(degrees * (HUE_WHEEL / 360.0f) + ((degrees >= 0.0f) ? 0.5f : -0.5f));
+}
+
+/**
+ * @brief Calculates sin(phase) for a phase in [0, WAVE_PERIOD].
+ *
+ * @param phase Phase where WAVE_PERIOD represents 2*PI.
+ * @return Sine of the phase in Q14.
+ */
+static int32_t wave_sine(uint32_t phase)
+{
+    // Reduce to a 16-bit angle: 2 bits of quadrant, 14 bits within it
+    uint16_t angle = (uint16_t)(phase >> 8);
+    uint8_t quadrant = angle >> 14;
+    uint16_t index = angle & 0x3FFFU;
+    int32_t value = 0;
+
+    if (quadrant & 0x01U)
+    {
+        // Falling half of each lobe mirrors the rising half
+        index = 0x4000U - index;
+    }
+
+    // Linearly interpolate between table entries (64 steps per quadrant)
+    value = sine_quarter[index >> 8];
+    if ((index & 0xFFU) != 0U)
+    {
+        value += ((sine_quarter[(index >> 8) + 1] - value) * (int32_t)(index & 0xFFU)) >> 8;
+    }
+
+    return (quadrant & 0x02U) ? -value : value;
+}
+
+/**
+ * @brief Initializes a fixed-point waveform.
+ *
+ * Mirrors function_generator_init(), with the sample rate fixed at
+ * ANIMATION_DELAY. The range is given in the fixed-point units the samples
+ * are wanted in, so that sampling is integer only.
+ */
+lcm_status_t wave_init(wave_t *wave, const waveform_t type, const float period_ms,
+                       const int32_t min_value, const int32_t max_value, const uint8_t flags,
+                       const uint16_t sequence)
+{
+    if (wave == NULL)
+    {
+        return LCM_ERROR_NULL_POINTER;
+    }
+
+    if (period_ms <= 0.0f || min_value > max_value)
+    {
+        return LCM_ERROR_INVALID_PARAM;
+    }
+
+    wave->type = type;
+    wave->increment = (uint32_t)((float)WAVE_PERIOD * ANIMATION_DELAY / period_ms + 0.5f);
+    wave->repeat = (flags & FG_FLAG_REPEAT) != 0;
+    wave->inverse = (flags & FG_FLAG_INVERT) != 0;
+    wave->sequence = sequence;
+    wave->scale = (max_value - min_value) / 2;
+    wave->offset = (max_value + min_value) / 2;
+    wave->phase = 0U;
+
+    if (type == FUNCTION_GENERATOR_SQUARE || type == FUNCTION_GENERATOR_SINE)
+    {
+        wave->phase = (WAVE_PERIOD / 4U) * 3U; // Start at 270 degrees
+    }
+
+    return LCM_SUCCESS;
+}
+
+/**
+ * @brief Calculates a waveform sample at the given phase.
+ *
+ * @param wave Pointer to the waveform.
+ * @param phase Phase to sample, in [0, WAVE_PERIOD].
+ * @param sample Pointer to store the sample.
+ * @return LCM_STOP_ITERATION at the end of a non-repeating wave,
+ * LCM_SUCCESS otherwise.
+ */
+lcm_status_t wave_sample(const wave_t *wave, const uint32_t phase, int32_t *sample)
+{
+    int32_t normalized_sample = 0;
+
+    if (wave == NULL || sample == NULL)
+    {
+        return LCM_ERROR_NULL_POINTER;
+    }
+
+    if (phase > WAVE_PERIOD)
+    {
+        return LCM_ERROR_INVALID_PARAM;
+    }
+
+    switch (wave->type)
+    {
+    case FUNCTION_GENERATOR_SINE:
+        normalized_sample = wave_sine(phase);
+        break;
+    case FUNCTION_GENERATOR_SQUARE:
+        normalized_sample = (phase < WAVE_PERIOD / 2U) ? -WAVE_ONE : WAVE_ONE;
+        break;
+    case FUNCTION_GENERATOR_SAWTOOTH:
+        normalized_sample = (int32_t)(phase >> 9) - WAVE_ONE;
+        break;
+    case FUNCTION_GENERATOR_SEQUENCE: {
+        uint8_t step = (uint8_t)(phase >> 20);
+        if (step > 15U)
+        {
+            step = 15U;
+        }
+        normalized_sample = (wave->sequence & (1U << (15U - step))) ? WAVE_ONE : -WAVE_ONE;
+        break;
+    }
+    default:
+        return LCM_ERROR_INVALID_PARAM;
+    }
+
+    if (wave->inverse)
+    {
+        normalized_sample = -normalized_sample;
+    }
+
+    // Map the normalized sample (-1 to 1) to [min_value, max_value]
+    *sample = ((wave->scale * normalized_sample) >> 14) + wave->offset;
+
+    if (phase >= WAVE_PERIOD && wave->repeat == false)
+    {
+        return LCM_STOP_ITERATION;
+    }
+
+    return LCM_SUCCESS;
+}
+
+/**
+ * @brief Retrieves the next sample of the waveform and advances the phase.
+ */
+lcm_status_t wave_next_sample(wave_t *wave, int32_t *sample)
+{
+    lcm_status_t result = LCM_SUCCESS;
+
+    if (wave == NULL || sample == NULL)
+    {
+        return LCM_ERROR_NULL_POINTER;
+    }
+
+    result = wave_sample(wave, wave->phase, sample);
+    if (result == LCM_SUCCESS)
+    {
+        wave->phase += wave->increment;
+        if (wave->phase >= WAVE_PERIOD)
+        {
+            wave->phase = wave->repeat ? (wave->phase % WAVE_PERIOD) : WAVE_PERIOD;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Retrieves a sample of the waveform at an offset without advancing it.
+ */
+lcm_status_t wave_peek_sample(const wave_t *wave, int32_t *sample, const uint16_t offset)
+{
+    uint32_t future_phase = 0U;
+
+    if (wave == NULL || sample == NULL)
+    {
+        return LCM_ERROR_NULL_POINTER;
+    }
+
+    future_phase = wave->phase + wave->increment * offset;
+    if (future_phase >= WAVE_PERIOD)
+    {
+        future_phase = wave->repeat ? (future_phase % WAVE_PERIOD) : WAVE_PERIOD;
+    }
+
+    return wave_sample(wave, future_phase, sample);
+}
+
 /**
  * @brief Calculate the brightness of a status LED.
  *
  * This function calculates the brightness of a status LED based on a Gaussian
- * distribution centered at `mu` with a standard deviation of `sigma`. The
- * brightness is determined by the distance of the LED index `i` from the
- * center `mu`, and it is clamped between 0.0 and 1.0.
+ * distribution centered at `mu`. The distance of the LED index `i` from `mu`
+ * is scaled by 1 / sigma into the unit gaussian table and the result is
+ * interpolated between the two nearest entries.
  *
- * @param mu The mean value or center of the distribution.
- * @param sigma The standard deviation, controlling the spread of the
- * distribution.
+ * @param mu The mean value or center of the distribution (Q8.8).
+ * @param inv_sigma 1 / sigma in Q12, at most 4096 / SIGMA_MIN so the scaled distance fits.
  * @param i The index of the LED for which brightness is being calculated.
- * @return The calculated brightness value, clamped between 0.0 and 1.0.
+ * @return The calculated brightness value in Q15, between 0 and Q15_ONE.
  */
-float calculate_brightness(float mu, float sigma, uint8_t i)
+uint16_t calculate_brightness(int32_t mu, uint32_t inv_sigma, uint8_t i)
 {
-    float distance = (i - mu);
-    float value = tiny_expf(-0.5f * (distance * distance) / (sigma * sigma));
-    return (CLAMP(value, 0.0f, 1.0f));
+    int32_t distance = ((int32_t)i * Q8_ONE) - mu;
+    uint32_t t = 0U;
+    uint32_t index = 0U;
+    uint32_t fraction = 0U;
+
+    // Distance in sigmas, with 8 fractional bits per table step
+    t = ((uint32_t)((distance < 0) ? -distance : distance) * inv_sigma) >> 8;
+    index = t >> 8;
+    fraction = t & 0xFFU;
+
+    if (index >= GAUSSIAN_STEPS)
+    {
+        return 0U;
+    }
+
+    return (uint16_t)(gaussian_kernel[index] -
+                      (((gaussian_kernel[index] - gaussian_kernel[index + 1]) * fraction) >> 8));
 }
 
 /**
- * @brief Starts the animation timer with the specified callback.
+ * @brief Advances a repeating wave by the extra phase of a modulated speed.
+ *
+ * Called once per frame, on top of the normal phase increment.
  */
-void animation_start(animation_tick_t callback)
+static void modulate_speed(wave_t *wave)
 {
-    if (callback != NULL)
+    if (((modulation_targets & ANIMATION_MOD_SPEED) != 0U) && wave->repeat)
     {
-        timer_callback = callback;
-        animation_timer = set_timer(ANIMATION_DELAY, TIMER_CALLBACK_NAME(animation, tick), true);
+        // Up to MODULATION_SPEED_MAX times the normal speed at full strength
+        wave->phase += (wave->increment >> 8) * modulation_level * (MODULATION_SPEED_MAX - 1U);
+        wave->phase %= WAVE_PERIOD;
     }
-    else
+}
+
+/**
+ * @brief Returns the hue shift (hue wheel units) of a modulated hue.
+ */
+static int32_t modulate_hue(void)
+{
+    int32_t shift = 0;
+
+    if ((modulation_targets & ANIMATION_MOD_HUE) != 0U)
     {
-        fault(EMERGENCY_FAULT_NULL_POINTER);
+        shift = (modulation_level * MODULATION_HUE_SHIFT) >> 8;
     }
+
+    return shift;
 }
 
 /**
- * @brief Calculate the mu value for a given sigma and threshold.
+ * @brief Scales a brightness (Q8.8) by a modulated brightness.
  */
-float calculate_mu_falloff(float sigma, float threshold)
+static int32_t modulate_brightness(int32_t brightness)
 {
-    if (threshold <= 0 || threshold >= 1)
+    if ((modulation_targets & ANIMATION_MOD_BRIGHTNESS) != 0U)
     {
-        return -1.0f; // Invalid threshold
+        int32_t scale = MODULATION_BRIGHTNESS_MIN +
+                        (((Q8_ONE - MODULATION_BRIGHTNESS_MIN) * modulation_level) >> 8);
+        brightness = (brightness * scale) >> 8;
+    }
+
+    return brightness;
+}
+
+/**
+ * @brief Starts the animation timer with the specified callback.
+ */
+void animation_start(animation_tick_t callback)
+{
+    if (callback != NULL)
+    {
+        timer_callback = callback;
+        modulation_targets = ANIMATION_MOD_NONE;
+
+        // Keep the timer if a crossfade or the previous animation is using it
+        if ((animation_timer == INVALID_TIMER_ID) || !is_timer_active(animation_timer))
+        {
+            animation_timer =
+                set_timer(ANIMATION_DELAY, TIMER_CALLBACK_NAME(animation, tick), true);
+        }
+    }
+    else
+    {
+        fault(EMERGENCY_FAULT_NULL_POINTER);
     }
-    return sqrtf(-2.0f * sigma * sigma * logf(threshold));
 }
 
 /**
@@ -239,6 +598,66 @@ void hsl_to_rgb(float h, float s, float l, status_leds_color_t *color)
     }
 }
 
+/**
+ * @brief Converts a hue to an RGB color at full saturation and half lightness.
+ *
+ * Integer equivalent of hsl_to_rgb(h, SATURATION_DEFAULT, LIGHTNESS_DEFAULT)
+ * used by the animation ticks. With those defaults the chroma is 1 and the
+ * offset is 0, so each sector of the color wheel is one channel ramping up
+ * or down while the other two are held at 255 and 0.
+ *
+ * @param hue The hue in hue wheel units (HUE_WHEEL = 360 degrees).
+ * @param color Pointer to a status_leds_color_t struct to store the result.
+ */
+void hue_to_rgb(int32_t hue, status_leds_color_t *color)
+{
+    uint8_t position = 0U;
+    uint8_t rising = 0U;
+    uint8_t falling = 0U;
+
+    if (color == NULL)
+    {
+        return;
+    }
+
+    // Hue ranges rarely stray more than one turn outside the wheel
+    while (hue >= HUE_WHEEL)
+    {
+        hue -= HUE_WHEEL;
+    }
+    while (hue < 0)
+    {
+        hue += HUE_WHEEL;
+    }
+
+    // Same truncation as hsl_to_rgb: x * 255 with x = position / HUE_SECTOR
+    position = (uint8_t)(hue & (HUE_SECTOR - 1));
+    rising = (uint8_t)((position * 255U) >> 8);
+    falling = (uint8_t)(((HUE_SECTOR - position) * 255U) >> 8);
+
+    switch (hue >> 8)
+    {
+    case 0:
+        color->r = 255U, color->g = rising, color->b = 0U;
+        break;
+    case 1:
+        color->r = falling, color->g = 255U, color->b = 0U;
+        break;
+    case 2:
+        color->r = 0U, color->g = 255U, color->b = rising;
+        break;
+    case 3:
+        color->r = 0U, color->g = falling, color->b = 255U;
+        break;
+    case 4:
+        color->r = rising, color->g = 0U, color->b = 255U;
+        break;
+    default:
+        color->r = 255U, color->g = 0U, color->b = falling;
+        break;
+    }
+}
+
 /**
  * @brief Updates the color based on the current animation mode.
  *
@@ -256,7 +675,7 @@ void hsl_to_rgb(float h, float s, float l, status_leds_color_t *color)
  */
 void next_color(status_leds_color_t *color, color_animation_t *color_animation)
 {
-    float h = 0.0f;
+    int32_t h = 0;
 
     if (color != NULL && color_animation != NULL)
     {
@@ -269,13 +688,13 @@ void next_color(status_leds_color_t *color, color_animation_t *color_animation)
         case COLOR_MODE_HSV_INCREASE:
             // Fall-through intentional
         case COLOR_MODE_HSV_DECREASE:
-            if (LCM_SUCCESS != function_generator_next_sample(&(color_animation->fg), &h))
+            if (LCM_SUCCESS != wave_next_sample(&(color_animation->wave), &h))
             {
                 // This should never return false unless we forgot
                 // to enable repeating
                 fault(EMERGENCY_FAULT_INVALID_ARGUMENT);
             }
-            hsl_to_rgb(h, SATURATION_DEFAULT, LIGHTNESS_DEFAULT, color);
+            hue_to_rgb(h + modulate_hue(), color);
             break;
         case COLOR_MODE_RGB:
             if (color_animation->rgb != NULL)
@@ -313,27 +732,27 @@ void brightness_init(brightness_animation_t *brightness_animation,
         switch (brightness_mode)
         {
         case BRIGHTNESS_MODE_FLASH:
-            function_generator_init(&(brightness_animation->fg), FUNCTION_GENERATOR_SQUARE,
-                                    brightness_speed, ANIMATION_DELAY, brightness_min,
-                                    brightness_max, FG_FLAG_REPEAT | FG_FLAG_INVERT, 0);
+            wave_init(&(brightness_animation->wave), FUNCTION_GENERATOR_SQUARE, brightness_speed,
+                      float_to_q8(brightness_min), float_to_q8(brightness_max),
+                      FG_FLAG_REPEAT | FG_FLAG_INVERT, 0);
             break;
         case BRIGHTNESS_MODE_SINE:
-            function_generator_init(&(brightness_animation->fg), FUNCTION_GENERATOR_SINE,
-                                    brightness_speed, ANIMATION_DELAY, brightness_min,
-                                    brightness_max, FG_FLAG_REPEAT, 0);
+            wave_init(&(brightness_animation->wave), FUNCTION_GENERATOR_SINE, brightness_speed,
+                      float_to_q8(brightness_min), float_to_q8(brightness_max),
+                      FG_FLAG_REPEAT, 0);
             break;
         case BRIGHTNESS_MODE_STATIC:
-            brightness_animation->static_value = brightness_max;
+            brightness_animation->static_value = float_to_q8(brightness_max);
             break;
         case BRIGHTNESS_MODE_FADE:
-            function_generator_init(&(brightness_animation->fg), FUNCTION_GENERATOR_SAWTOOTH,
-                                    brightness_speed, ANIMATION_DELAY, brightness_min,
-                                    brightness_max, FG_FLAG_INVERT | FG_FLAG_REPEAT, 0);
+            wave_init(&(brightness_animation->wave), FUNCTION_GENERATOR_SAWTOOTH, brightness_speed,
+                      float_to_q8(brightness_min), float_to_q8(brightness_max),
+                      FG_FLAG_INVERT | FG_FLAG_REPEAT, 0);
             break;
         case BRIGHTNESS_MODE_SEQUENCE:
-            function_generator_init(&(brightness_animation->fg), FUNCTION_GENERATOR_SEQUENCE,
-                                    brightness_speed, ANIMATION_DELAY, brightness_min,
-                                    brightness_max, FG_FLAG_REPEAT, brightness_sequence);
+            wave_init(&(brightness_animation->wave), FUNCTION_GENERATOR_SEQUENCE, brightness_speed,
+                      float_to_q8(brightness_min), float_to_q8(brightness_max),
+                      FG_FLAG_REPEAT, brightness_sequence);
             break;
         default:
             fault(EMERGENCY_FAULT_INVALID_ARGUMENT);
@@ -347,11 +766,11 @@ void brightness_init(brightness_animation_t *brightness_animation,
 }
 
 /**
- * @brief Calculates the next brightness value for the animation.
+ * @brief Calculates the next brightness value (Q8.8) for the animation.
  */
-float next_brightness(brightness_animation_t *brightness_animation)
+int32_t next_brightness(brightness_animation_t *brightness_animation)
 {
-    float b = 0.0f;
+    int32_t b = 0;
 
     if (brightness_animation != NULL)
     {
@@ -361,7 +780,7 @@ float next_brightness(brightness_animation_t *brightness_animation)
         }
         else
         {
-            if (LCM_SUCCESS != function_generator_next_sample(&(brightness_animation->fg), &b))
+            if (LCM_SUCCESS != wave_next_sample(&(brightness_animation->wave), &b))
             {
                 fault(EMERGENCY_FAULT_INVALID_ARGUMENT);
             }
@@ -402,22 +821,24 @@ void color_init(color_animation_t *color_animation, color_mode_t color_mode, flo
         switch (color_mode)
         {
         case COLOR_MODE_HSV_INCREASE:
-            function_generator_init(&(color_animation->fg), FUNCTION_GENERATOR_SAWTOOTH,
-                                    color_speed, ANIMATION_DELAY, hue_min, hue_max, FG_FLAG_REPEAT,
-                                    0);
+            wave_init(&(color_animation->wave), FUNCTION_GENERATOR_SAWTOOTH, color_speed,
+                      degrees_to_hue(hue_min), degrees_to_hue(hue_max),
+                      FG_FLAG_REPEAT, 0);
             break;
         case COLOR_MODE_HSV_DECREASE:
-            function_generator_init(&(color_animation->fg), FUNCTION_GENERATOR_SAWTOOTH,
-                                    color_speed, ANIMATION_DELAY, hue_min, hue_max,
-                                    FG_FLAG_INVERT | FG_FLAG_REPEAT, 0);
+            wave_init(&(color_animation->wave), FUNCTION_GENERATOR_SAWTOOTH, color_speed,
+                      degrees_to_hue(hue_min), degrees_to_hue(hue_max),
+                      FG_FLAG_INVERT | FG_FLAG_REPEAT, 0);
             break;
         case COLOR_MODE_HSV_SINE:
-            function_generator_init(&(color_animation->fg), FUNCTION_GENERATOR_SINE, color_speed,
-                                    ANIMATION_DELAY, hue_min, hue_max, FG_FLAG_REPEAT, 0);
+            wave_init(&(color_animation->wave), FUNCTION_GENERATOR_SINE, color_speed,
+                      degrees_to_hue(hue_min), degrees_to_hue(hue_max),
+                      FG_FLAG_REPEAT, 0);
             break;
         case COLOR_MODE_HSV_SQUARE:
-            function_generator_init(&(color_animation->fg), FUNCTION_GENERATOR_SQUARE, color_speed,
-                                    ANIMATION_DELAY, hue_min, hue_max, FG_FLAG_REPEAT, 0);
+            wave_init(&(color_animation->wave), FUNCTION_GENERATOR_SQUARE, color_speed,
+                      degrees_to_hue(hue_min), degrees_to_hue(hue_max),
+                      FG_FLAG_REPEAT, 0);
             break;
         case COLOR_MODE_RGB:
             if (rgb != NULL)
@@ -444,20 +865,21 @@ void color_init(color_animation_t *color_animation, color_mode_t color_mode, flo
  * @brief Scales the brightness of the given color
  *
  * This function scales the RGB values of the given color by the given
- * brightness. The brightness is a float between 0.0f and 1.0f, where 0.0f
- * represents black and 1.0f represents the original color.
+ * brightness. The brightness is in Q8.8 between 0 and Q8_ONE, where 0
+ * represents black and Q8_ONE represents the original color.
  *
  * @param color Pointer to a status_leds_color_t struct to scale the brightness
  * of.
- * @param brightness The brightness to scale the color to.
+ * @param brightness The brightness to scale the color to (Q8.8).
  */
-void scale_brightness(status_leds_color_t *color, float brightness)
+void scale_brightness(status_leds_color_t *color, int32_t brightness)
 {
     if (color != NULL)
     {
-        color->r = (uint8_t)(color->r * brightness);
-        color->g = (uint8_t)(color->g * brightness);
-        color->b = (uint8_t)(color->b * brightness);
+        brightness = CLAMP(brightness, 0, Q8_ONE);
+        color->r = (uint8_t)((color->r * brightness) >> 8);
+        color->g = (uint8_t)((color->g * brightness) >> 8);
+        color->b = (uint8_t)((color->b * brightness) >> 8);
     }
 }
 
@@ -465,7 +887,7 @@ void scale_brightness(status_leds_color_t *color, float brightness)
  * @brief Fills the specified range of LEDs with a gradient color.
  */
 void gradient_fill(status_leds_color_t *buffer, color_animation_t *color_animation,
-                   uint8_t first_led, uint8_t last_led, float brightness)
+                   uint8_t first_led, uint8_t last_led, int32_t brightness)
 {
     if (color_animation == NULL || color_animation->mode == COLOR_MODE_RGB)
     {
@@ -474,7 +896,7 @@ void gradient_fill(status_leds_color_t *buffer, color_animation_t *color_animati
     }
 
     status_leds_color_t color = {0};
-    float h = 0.0f;
+    int32_t h = 0;
 
     int8_t step = (first_led <= last_led) ? 1 : -1;
     uint8_t count = (first_led <= last_led) ? (last_led - first_led + 1) : (first_led - last_led + 1);
@@ -484,12 +906,12 @@ void gradient_fill(status_leds_color_t *buffer, color_animation_t *color_animati
     for (uint8_t idx = 0; idx < count; idx++)
     {
         uint8_t i = first_led + step * idx;
-        if (LCM_SUCCESS != function_generator_peek_sample(&(color_animation->fg), &h, idx))
+        if (LCM_SUCCESS != wave_peek_sample(&(color_animation->wave), &h, idx))
         {
             fault(EMERGENCY_FAULT_INVALID_ARGUMENT);
         }
 
-        hsl_to_rgb(h, SATURATION_DEFAULT, LIGHTNESS_DEFAULT, &color);
+        hue_to_rgb(h + modulate_hue(), &color);
         scale_brightness(&color, brightness);
 
         buffer[i].r = color.r;
@@ -498,6 +920,33 @@ void gradient_fill(status_leds_color_t *buffer, color_animation_t *color_animati
     }
 }
 
+/**
+ * @brief Draws a bar filled up to the given level.
+ */
+void bar_fill(status_leds_color_t *buffer, int32_t level, const status_leds_color_t *color)
+{
+    const uint32_t inv_sigma = (uint32_t)(4096.0f / SIGMA_DEFAULT + 0.5f);
+    uint8_t led_count = status_leds_get_count();
+
+    if ((buffer == NULL) || (color == NULL))
+    {
+        fault(EMERGENCY_FAULT_NULL_POINTER);
+        return;
+    }
+
+    for (uint8_t i = 0; i < led_count; i++)
+    {
+        // LEDs below the level are fully lit, the edge falls off like a scan
+        uint16_t brightness = (((int32_t)i * Q8_ONE) < level)
+                                  ? Q15_ONE
+                                  : calculate_brightness(level, inv_sigma, i);
+
+        buffer[i].r = (uint8_t)((color->r * brightness) >> 15);
+        buffer[i].g = (uint8_t)((color->g * brightness) >> 15);
+        buffer[i].b = (uint8_t)((color->b * brightness) >> 15);
+    }
+}
+
 /**
  * @brief Ticks the fill animation
  */
@@ -505,13 +954,21 @@ void fill_animation_tick(uint32_t tick)
 {
     status_leds_color_t color = {0};
     uint8_t midpoint = 0;
-    float b = 0.0f;
+    int32_t b = 0;
 
     // Clear the LEDs
-    status_leds_set_color(&color, 0, STATUS_LEDS_COUNT - 1);
+    status_leds_set_color(&color, 0, status_leds_get_count() - 1U);
 
     // Get the next brightness
-    b = next_brightness(&animation_config.fill.brightness);
+    b = modulate_brightness(next_brightness(&animation_config.fill.brightness));
+    if (animation_config.fill.color.mode != COLOR_MODE_RGB)
+    {
+        modulate_speed(&animation_config.fill.color.wave);
+    }
+    if (animation_config.fill.brightness.mode != BRIGHTNESS_MODE_STATIC)
+    {
+        modulate_speed(&animation_config.fill.brightness.wave);
+    }
 
     // Update the LEDs
     switch (animation_config.fill.mode)
@@ -588,46 +1045,51 @@ void fill_animation_tick(uint32_t tick)
 void scan_animation_tick(uint32_t tick)
 {
     status_leds_color_t color = {0};
-    float range = 0.0f;
-    float increment = 0.0f;
-    float global_brightness = 0.0f;
-    float mu = 0.0f;
-    float sigma = 0.0f;
+    int32_t mu = 0;
+    uint8_t led_count = status_leds_get_count();
     bool mirror = (animation_config.scan.direction == SCAN_DIRECTION_LEFT_TO_RIGHT_MIRROR) ||
                   (animation_config.scan.direction == SCAN_DIRECTION_RIGHT_TO_LEFT_MIRROR);
 
     // Update animation parameters
-    if (LCM_SUCCESS != function_generator_next_sample(&animation_config.scan.fg, &mu))
+    if (LCM_SUCCESS != wave_next_sample(&animation_config.scan.wave, &mu))
     {
         // No more samples, disable animation
         stop_animation();
     }
+    modulate_speed(&animation_config.scan.wave);
     next_color(&color, &animation_config.scan.color);
+    scale_brightness(&color, modulate_brightness(Q8_ONE));
+    if (animation_config.scan.color.mode != COLOR_MODE_RGB)
+    {
+        modulate_speed(&animation_config.scan.color.wave);
+    }
 
     // Step 3: Update the LEDs
-    for (uint8_t i = 0; i < STATUS_LEDS_COUNT; i++)
+    for (uint8_t i = 0; i < led_count; i++)
     {
-        float brightness = 0.0f;
+        int32_t position = (int32_t)i * Q8_ONE;
+        uint16_t brightness = 0U;
 
-        // Calculate the brightness based on the distance from the center
-        if (animation_config.scan.direction == SCAN_DIRECTION_LEFT_TO_RIGHT_FILL && i < mu)
+        // Calculate the brightness (Q15) based on the distance from the center
+        if (animation_config.scan.direction == SCAN_DIRECTION_LEFT_TO_RIGHT_FILL && position < mu)
         {
-            brightness = 1.0f;
+            brightness = Q15_ONE;
         }
-        else if (animation_config.scan.direction == SCAN_DIRECTION_RIGHT_TO_LEFT_FILL && i > mu)
+        else if (animation_config.scan.direction == SCAN_DIRECTION_RIGHT_TO_LEFT_FILL &&
+                 position > mu)
         {
-            brightness = 1.0f;
+            brightness = Q15_ONE;
         }
         else
         {
-            brightness = calculate_brightness(mu, animation_config.scan.sigma, i);
+            brightness = calculate_brightness(mu, animation_config.scan.inv_sigma, i);
         }
 
         if (animation_config.scan.buffer != NULL)
         {
-            animation_config.scan.buffer[i].r = (uint8_t)(color.r * brightness);
-            animation_config.scan.buffer[i].g = (uint8_t)(color.g * brightness);
-            animation_config.scan.buffer[i].b = (uint8_t)(color.b * brightness);
+            animation_config.scan.buffer[i].r = (uint8_t)((color.r * brightness) >> 15);
+            animation_config.scan.buffer[i].g = (uint8_t)((color.g * brightness) >> 15);
+            animation_config.scan.buffer[i].b = (uint8_t)((color.b * brightness) >> 15);
         }
         else
         {
@@ -639,13 +1101,13 @@ void scan_animation_tick(uint32_t tick)
     // Step 4: mirror the left and right sides of the area
     if (mirror)
     {
-        for (uint8_t i = 0; i < STATUS_LEDS_COUNT / 2; i++)
+        for (uint8_t i = 0; i < led_count / 2; i++)
         {
-            animation_config.scan.buffer[STATUS_LEDS_COUNT - 1 - i].r =
+            animation_config.scan.buffer[led_count - 1 - i].r =
                 animation_config.scan.buffer[i].r;
-            animation_config.scan.buffer[STATUS_LEDS_COUNT - 1 - i].g =
+            animation_config.scan.buffer[led_count - 1 - i].g =
                 animation_config.scan.buffer[i].g;
-            animation_config.scan.buffer[STATUS_LEDS_COUNT - 1 - i].b =
+            animation_config.scan.buffer[led_count - 1 - i].b =
                 animation_config.scan.buffer[i].b;
         }
     }
@@ -657,12 +1119,14 @@ void scan_animation_tick(uint32_t tick)
  */
 void fade_animation_tick(uint32_t tick)
 {
+    uint8_t led_count = status_leds_get_count();
+
     animation_config.fade.elapsed_ms += ANIMATION_DELAY;
 
     if (animation_config.fade.elapsed_ms >= animation_config.fade.period_ms)
     {
         // Fade animation is complete
-        for (uint8_t i = 0; i < STATUS_LEDS_COUNT; i++)
+        for (uint8_t i = 0; i < led_count; i++)
         {
             animation_config.fade.buffer[i].r = 0;
             animation_config.fade.buffer[i].g = 0;
@@ -670,8 +1134,8 @@ void fade_animation_tick(uint32_t tick)
         }
         status_leds_refresh();
 
-        // Stop the timer
-        cancel_timer(animation_timer);
+        // Stop the animation, the timer keeps running for a crossfade
+        stop_animation();
 
         // Call the callback
         if (animation_config.fade.callback != NULL)
@@ -681,18 +1145,20 @@ void fade_animation_tick(uint32_t tick)
     }
     else
     {
-        // Update the LEDs
-        float fade_factor = 1.0f - ((float)animation_config.fade.elapsed_ms /
-                                    (float)animation_config.fade.period_ms);
+        // Update the LEDs, one division per frame and a multiply per channel
+        uint16_t fade_factor = (uint16_t)(((uint32_t)(animation_config.fade.period_ms -
+                                                      animation_config.fade.elapsed_ms)
+                                           << 8) /
+                                          animation_config.fade.period_ms);
 
-        for (uint8_t i = 0; i < STATUS_LEDS_COUNT; i++)
+        for (uint8_t i = 0; i < led_count; i++)
         {
             animation_config.fade.buffer[i].r =
-                (uint8_t)(animation_config.fade.buffer[i].r * fade_factor);
+                (uint8_t)((animation_config.fade.buffer[i].r * fade_factor) >> 8);
             animation_config.fade.buffer[i].g =
-                (uint8_t)(animation_config.fade.buffer[i].g * fade_factor);
+                (uint8_t)((animation_config.fade.buffer[i].g * fade_factor) >> 8);
             animation_config.fade.buffer[i].b =
-                (uint8_t)(animation_config.fade.buffer[i].b * fade_factor);
+                (uint8_t)((animation_config.fade.buffer[i].b * fade_factor) >> 8);
         }
 
         status_leds_refresh();
@@ -705,10 +1171,12 @@ void fade_animation_tick(uint32_t tick)
  */
 void fire_animation_tick(uint32_t tick)
 {
+    uint8_t led_count = status_leds_get_count();
+
     animation_config.fire.prng_state = (animation_config.fire.prng_state ^ tick) % 256;
 
     // Update the fire animation
-    for (uint8_t i = 0; i < STATUS_LEDS_COUNT; i++)
+    for (uint8_t i = 0; i < led_count; i++)
     {
         // Cool down every LED a little
         animation_config.fire.heat[i] = qsub8(animation_config.fire.heat[i],
@@ -716,7 +1184,7 @@ void fire_animation_tick(uint32_t tick)
     }
 
     // Heat from each cell drifts 'up' and diffuses a little
-    for (uint8_t i = STATUS_LEDS_COUNT - 1; i >= 2; i--)
+    for (uint8_t i = led_count - 1; i >= 2; i--)
     {
         animation_config.fire.heat[i] =
             (animation_config.fire.heat[i - 1] + animation_config.fire.heat[i - 2] +
@@ -732,7 +1200,7 @@ void fire_animation_tick(uint32_t tick)
             qadd8(animation_config.fire.heat[y], prng(&animation_config.fire.prng_state, 160, 255));
     }
 
-    for (uint8_t i = 0; i < STATUS_LEDS_COUNT; i++)
+    for (uint8_t i = 0; i < led_count; i++)
     {
         // Map from heat to LED colors
         uint8_t t192 = scale8(animation_config.fire.heat[i], 192);
@@ -774,9 +1242,10 @@ uint16_t scan_animation_setup(status_leds_color_t *buffer, scan_direction_t dire
                               scan_start_t scan_start, scan_end_t scan_end, float init_mu,
                               const status_leds_color_t *rgb)
 {
-    float mu_falloff = calculate_mu_falloff(sigma, 0.01f);
+    uint8_t led_count = status_leds_get_count();
+    float mu_falloff = sigma * GAUSSIAN_FALLOFF;
     float mu_start = 0.0f;
-    float mu_end = STATUS_LEDS_COUNT - 1 + mu_falloff;
+    float mu_end = led_count - 1 + mu_falloff;
 
     if (scan_start == SCAN_START_DEFAULT)
     {
@@ -787,38 +1256,44 @@ uint16_t scan_animation_setup(status_leds_color_t *buffer, scan_direction_t dire
         mu_start = init_mu;
     }
 
+    // Narrower scans would overflow the distance scaling in calculate_brightness
+    if (sigma < SIGMA_MIN)
+    {
+        fault(EMERGENCY_FAULT_INVALID_ARGUMENT);
+        return animation_id;
+    }
+
     // Copy the animation configuration
     animation_config.scan.buffer = buffer;
-    animation_config.scan.sigma = sigma;
     animation_config.scan.direction = direction;
+    animation_config.scan.inv_sigma = (uint32_t)(4096.0f / sigma + 0.5f);
 
     switch (direction)
     {
     case SCAN_DIRECTION_LEFT_TO_RIGHT_MIRROR:
-        mu_end = (STATUS_LEDS_COUNT / 2) - 1 + mu_falloff;
+        mu_end = (led_count / 2) - 1 + mu_falloff;
         // fallthrough intentional
     case SCAN_DIRECTION_LEFT_TO_RIGHT_FILL:
         // fallthrough intentional
     case SCAN_DIRECTION_LEFT_TO_RIGHT:
-        function_generator_init(&(animation_config.scan.fg), FUNCTION_GENERATOR_SAWTOOTH,
-                                movement_speed, ANIMATION_DELAY, mu_start, mu_end,
-                                scan_end == SCAN_END_NEVER ? FG_FLAG_REPEAT : FG_FLAG_NONE, 0);
+        wave_init(&(animation_config.scan.wave), FUNCTION_GENERATOR_SAWTOOTH, movement_speed,
+                  float_to_q8(mu_start), float_to_q8(mu_end),
+                  scan_end == SCAN_END_NEVER ? FG_FLAG_REPEAT : FG_FLAG_NONE, 0);
         break;
     case SCAN_DIRECTION_RIGHT_TO_LEFT_MIRROR:
-        mu_end = (STATUS_LEDS_COUNT / 2) - 1 + mu_falloff;
+        mu_end = (led_count / 2) - 1 + mu_falloff;
         // fallthrough intentional
     case SCAN_DIRECTION_RIGHT_TO_LEFT_FILL:
         // fallthrough intentional
     case SCAN_DIRECTION_RIGHT_TO_LEFT:
-        function_generator_init(
-            &(animation_config.scan.fg), FUNCTION_GENERATOR_SAWTOOTH, movement_speed,
-            ANIMATION_DELAY, mu_start, mu_end,
-            scan_end == SCAN_END_NEVER ? FG_FLAG_REPEAT | FG_FLAG_INVERT : FG_FLAG_INVERT, 0);
+        wave_init(&(animation_config.scan.wave), FUNCTION_GENERATOR_SAWTOOTH, movement_speed,
+                  float_to_q8(mu_start), float_to_q8(mu_end),
+                  scan_end == SCAN_END_NEVER ? FG_FLAG_REPEAT | FG_FLAG_INVERT : FG_FLAG_INVERT, 0);
         break;
     case SCAN_DIRECTION_SINE:
-        function_generator_init(&(animation_config.scan.fg), FUNCTION_GENERATOR_SINE,
-                                movement_speed, ANIMATION_DELAY, 0, STATUS_LEDS_COUNT - 1,
-                                scan_end == SCAN_END_NEVER ? FG_FLAG_REPEAT : FG_FLAG_NONE, 0);
+        wave_init(&(animation_config.scan.wave), FUNCTION_GENERATOR_SINE, movement_speed, 0,
+                  (led_count - 1) * Q8_ONE,
+                  scan_end == SCAN_END_NEVER ? FG_FLAG_REPEAT : FG_FLAG_NONE, 0);
         break;
     default:
         fault(EMERGENCY_FAULT_INVALID_ARGUMENT);
@@ -840,7 +1315,7 @@ uint16_t scan_animation_setup(status_leds_color_t *buffer, scan_direction_t dire
     }
 
     // Return the animation ID
-    return animation_id++;
+    return ++animation_id;
 }
 
 /**
@@ -867,7 +1342,7 @@ uint16_t fill_animation_setup(status_leds_color_t *buffer, color_mode_t color_mo
     animation_start(fill_animation_tick);
 
     // Return the animation ID
-    return animation_id++;
+    return ++animation_id;
 }
 
 /**
@@ -884,7 +1359,7 @@ uint16_t fade_animation_setup(status_leds_color_t *buffer, uint16_t period,
     animation_start(fade_animation_tick);
 
     // Return the animation ID
-    return animation_id++;
+    return ++animation_id;
 }
 
 #ifdef ENABLE_FIRE_ANIMATION
@@ -892,7 +1367,7 @@ uint16_t fire_animation_setup(status_leds_color_t *buffer)
 {
     animation_config.fire.buffer = buffer;
     animation_config.fire.prng_state = 123;
-    for (uint8_t i = 0; i < STATUS_LEDS_COUNT; i++)
+    for (uint8_t i = 0; i < STATUS_LEDS_MAX_COUNT; i++)
     {
         animation_config.fire.heat[i] = 0;
     }
@@ -900,25 +1375,89 @@ uint16_t fire_animation_setup(status_leds_color_t *buffer)
     animation_start(fire_animation_tick);
 
     // Return the animation ID
-    return animation_id++;
+    return ++animation_id;
 }
 #endif
 
+/**
+ * @brief Checks that an animation parameter block can be started.
+ */
+bool_t animation_params_valid(const animation_params_t *params)
+{
+    bool_t valid = true;
+
+    if (params == NULL)
+    {
+        valid = false;
+    }
+    else if (params->type == ANIMATION_TYPE_FADE)
+    {
+        valid = (params->period > 0U);
+    }
+    else if ((params->type == ANIMATION_TYPE_SCAN) || (params->type == ANIMATION_TYPE_FILL))
+    {
+        if ((params->color_mode > COLOR_MODE_RGB) ||
+            ((params->modulation & ~ANIMATION_MOD_MASK) != 0U))
+        {
+            valid = false;
+        }
+        else if ((params->color_mode != COLOR_MODE_RGB) &&
+                 ((params->color_speed == 0U) || (params->hue_min < -360) ||
+                  (params->hue_min > 360) || (params->hue_max < -360) || (params->hue_max > 360)))
+        {
+            valid = false;
+        }
+        else if (params->type == ANIMATION_TYPE_SCAN)
+        {
+            valid = (params->mode <= SCAN_DIRECTION_SINE) &&
+                    (params->scan_end <= SCAN_END_MAX_MU) && (params->sigma >= ANIMATION_SIGMA_MIN) &&
+                    (params->period > 0U);
+        }
+        else
+        {
+            valid = (params->mode <= FILL_MODE_HSV_GRADIENT_MIRROR) &&
+                    (params->brightness_mode <= BRIGHTNESS_MODE_SEQUENCE) &&
+                    ((params->brightness_mode == BRIGHTNESS_MODE_STATIC) ||
+                     (params->brightness_speed > 0U));
+        }
+    }
+#ifdef ENABLE_FIRE_ANIMATION
+    else if (params->type == ANIMATION_TYPE_FIRE)
+    {
+        valid = true;
+    }
+#endif
+    else
+    {
+        valid = false;
+    }
+
+    return valid;
+}
+
 /**
  * @brief Handle the timer tick for the animations.
  */
 TIMER_CALLBACK(animation, tick)
 {
+    if (crossfade_alpha > 0U)
+    {
+        crossfade_alpha =
+            (crossfade_alpha > crossfade_step) ? (uint8_t)(crossfade_alpha - crossfade_step) : 0U;
+        status_leds_refresh();
+    }
+
     if (timer_callback != NULL)
     {
         timer_callback(system_tick);
     }
-    else
+    else if (crossfade_alpha == 0U)
     {
-        // This should never happen unless the timer callback is not set
+        // Nothing left to animate
         cancel_timer(animation_timer);
         animation_timer = INVALID_TIMER_ID;
     }
+    // No else needed, the crossfade is still running
 }
 
 /**
@@ -930,7 +1469,8 @@ TIMER_CALLBACK(animation, tick)
  */
 void stop_animation(void)
 {
-    if (animation_timer != INVALID_TIMER_ID && is_timer_active(animation_timer))
+    if ((crossfade_alpha == 0U) && (animation_timer != INVALID_TIMER_ID) &&
+        is_timer_active(animation_timer))
     {
         cancel_timer(animation_timer);
         animation_timer = INVALID_TIMER_ID;
@@ -938,6 +1478,66 @@ void stop_animation(void)
     timer_callback = NULL;
 }
 
+#ifdef ENABLE_STATUS_LEDS_BENCHMARK
+/**
+ * @brief Runs one frame of the current animation now, without the timer.
+ */
+void animation_step(uint32_t tick)
+{
+    if (timer_callback != NULL)
+    {
+        timer_callback(tick);
+    }
+}
+#endif
+
+/**
+ * @brief Binds the running animation to the live modulation.
+ */
+void animation_modulate(uint8_t targets)
+{
+    modulation_targets = targets & ANIMATION_MOD_TARGETS;
+}
+
+/**
+ * @brief Sets the strength of the live modulation.
+ */
+void animation_set_modulation(uint8_t level)
+{
+    modulation_level = level;
+}
+
+/**
+ * @brief Starts a crossfade that lasts the given number of frames.
+ */
+void animation_crossfade_start(uint8_t frames)
+{
+    if (frames == 0U)
+    {
+        crossfade_alpha = 0U;
+        return;
+    }
+
+    crossfade_step = 255U / frames;
+    crossfade_alpha = 255U;
+
+    if ((animation_timer == INVALID_TIMER_ID) || !is_timer_active(animation_timer))
+    {
+        animation_timer = set_timer(ANIMATION_DELAY, TIMER_CALLBACK_NAME(animation, tick), true);
+    }
+}
+
+/**
+ * @brief Returns the opacity of the outgoing frame of the crossfade.
+ */
+uint8_t animation_crossfade_alpha(void)
+{
+    return crossfade_alpha;
+}
+
+/**
+ * @brief Returns the ID of the most recently started animation.
+ */
 uint16_t get_animation_id(void)
 {
     return animation_id;
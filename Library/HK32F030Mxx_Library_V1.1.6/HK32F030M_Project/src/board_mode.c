@@ -17,7 +17,6 @@
  * with ALCM. If not, see <https://www.gnu.org/licenses/>.
  */
 #include <stdlib.h>
-#include <math.h>
 
 #include "board_mode.h"
 #include "event_queue.h"
@@ -29,11 +28,10 @@
 
 // Forward declarations
 EVENT_HANDLER(board_mode, command);
-EVENT_HANDLER(board_mode, rpm_changed);
+EVENT_HANDLER(board_mode, telemetry_updated);
 EVENT_HANDLER(board_mode, fault);
 EVENT_HANDLER(board_mode, footpad_changed);
 EVENT_HANDLER(board_mode, vesc_alive);
-EVENT_HANDLER(board_mode, duty_cycle_changed);
 
 // Timer handlers
 void board_mode_idle_timer_handler(uint32_t system_tick);
@@ -72,46 +70,45 @@ lcm_status_t board_mode_init(void)
     SUBSCRIBE_EVENT(board_mode, EVENT_COMMAND_SHUTDOWN, command);
     SUBSCRIBE_EVENT(board_mode, EVENT_COMMAND_BOOT, command);
     SUBSCRIBE_EVENT(board_mode, EVENT_COMMAND_MODE_CONFIG, command);
-    SUBSCRIBE_EVENT(board_mode, EVENT_RPM_CHANGED, rpm_changed);
     SUBSCRIBE_EVENT(board_mode, EVENT_EMERGENCY_FAULT, fault);
-    SUBSCRIBE_EVENT(board_mode, EVENT_VESC_FAULT_CHANGED, fault);
     SUBSCRIBE_EVENT(board_mode, EVENT_FOOTPAD_CHANGED, footpad_changed);
     SUBSCRIBE_EVENT(board_mode, EVENT_VESC_ALIVE, vesc_alive);
-    SUBSCRIBE_EVENT(board_mode, EVENT_DUTY_CYCLE_CHANGED, duty_cycle_changed);
-#if defined(ENABLE_IMU_EVENTS)
-    SUBSCRIBE_EVENT(board_mode, EVENT_IMU_ROLL_CHANGED, command);
-#endif
+    SUBSCRIBE_EVENT(board_mode, EVENT_TELEMETRY_UPDATED, telemetry_updated);
 
     // Initialize hysteresis values
     if (LCM_SUCCESS != hysteresis_init(&stopped_rpm_hysteresis, STOPPED_RPM_THRESHOLD,
-                                       STOPPED_RPM_THRESHOLD - (STOPPED_RPM_THRESHOLD * 0.1f)))
+                                       STOPPED_RPM_THRESHOLD - (STOPPED_RPM_THRESHOLD / 10)))
     {
         status = LCM_ERROR;
     }
 
     if (LCM_SUCCESS != hysteresis_init(&slow_rpm_hysteresis, SLOW_RPM_THRESHOLD,
-                                       SLOW_RPM_THRESHOLD - (SLOW_RPM_THRESHOLD * 0.1f)))
+                                       SLOW_RPM_THRESHOLD - (SLOW_RPM_THRESHOLD / 10)))
     {
         status = LCM_ERROR;
     }
 
     if (LCM_SUCCESS != hysteresis_init(&danger_hysteresis, DUTY_CYCLE_DANGER_THRESHOLD,
-                                       DUTY_CYCLE_DANGER_THRESHOLD - 5.0f))
+                                       DUTY_CYCLE_DANGER_THRESHOLD - 50))
     {
         status = LCM_ERROR;
     }
 
     if (LCM_SUCCESS != hysteresis_init(&warning_hysteresis, DUTY_CYCLE_WARNING_THRESHOLD,
-                                       DUTY_CYCLE_WARNING_THRESHOLD - 5.0f))
+                                       DUTY_CYCLE_WARNING_THRESHOLD - 50))
     {
         status = LCM_ERROR;
     }
 
 #if defined(ENABLE_IMU_EVENTS)
-    if (LCM_SUCCESS != hysteresis_init(&roll_hysteresis,  45.0f, 40.0f)) // degrees
+    if (LCM_SUCCESS != hysteresis_init(&roll_hysteresis, ROLL_SET_THRESHOLD, ROLL_RESET_THRESHOLD))
     {
         status = LCM_ERROR;
     }
+
+    // Roll is only needed to doze and wake while idle. When riding, the roll
+    // state is held from the moment the board left idle.
+    vesc_serial_declare_demand(TELEMETRY_IMU_ROLL, BOARD_MODE_MASK(BOARD_MODE_IDLE));
 #endif
 
     return status;
@@ -239,6 +236,15 @@ EVENT_HANDLER(board_mode, vesc_alive)
     {
         set_board_mode(BOARD_MODE_IDLE, BOARD_SUBMODE_IDLE_ACTIVE);
     }
+    // If the VESC answers again after a communication timeout, and it isn't
+    // reporting a fault of its own, the board is ready again
+    else if (event == EVENT_VESC_ALIVE && board_mode == BOARD_MODE_FAULT &&
+             board_submode == BOARD_SUBMODE_FAULT_VESC &&
+             vesc_serial_get_telemetry()->fault == 0U)
+    {
+        set_board_mode(BOARD_MODE_IDLE, BOARD_SUBMODE_IDLE_ACTIVE);
+    }
+    // No else needed, VESC was already known to be alive
 }
 
 EVENT_HANDLER(board_mode, command)
@@ -294,26 +300,6 @@ EVENT_HANDLER(board_mode, command)
             set_board_mode(BOARD_MODE_OFF, BOARD_SUBMODE_UNDEFINED);
         }
         break;
-#ifdef ENABLE_IMU_EVENTS
-    case EVENT_IMU_ROLL_CHANGED:
-        if (roll_hysteresis.state != apply_hysteresis(&roll_hysteresis, fabsf(data->imu_roll))) {
-            // If the board is on its side, transition to dozing idle mode
-            if (board_mode == BOARD_MODE_IDLE &&
-                (board_submode == BOARD_SUBMODE_IDLE_ACTIVE || board_submode == BOARD_SUBMODE_IDLE_DEFAULT) &&
-                roll_hysteresis.state == STATE_SET)
-            {
-                set_board_mode(BOARD_MODE_IDLE, BOARD_SUBMODE_IDLE_DOZING);
-            }
-            // If the board is dozing and turned upright, transition to active idle mode
-            else if (board_mode == BOARD_MODE_IDLE &&
-                    board_submode == BOARD_SUBMODE_IDLE_DOZING &&
-                    roll_hysteresis.state == STATE_RESET)
-            {
-                set_board_mode(BOARD_MODE_IDLE, BOARD_SUBMODE_IDLE_ACTIVE);
-            }
-        }
-        break;
-#endif // ENABLE_IMU_EVENTS
     default:
         // Unexpected event
         break;
@@ -363,6 +349,8 @@ void board_mode_idle_timer_handler(uint32_t system_tick)
  * This function is called when the duty cycle or RPM values change. It sets
  * the riding submode based on the current duty cycle and RPM values.
  *
+ * @param telemetry The current telemetry snapshot
+ *
  * @see BOARD_SUBMODE_RIDING_DANGER
  * @see BOARD_SUBMODE_RIDING_WARNING
  * @see BOARD_SUBMODE_RIDING_NORMAL
@@ -371,10 +359,10 @@ void board_mode_idle_timer_handler(uint32_t system_tick)
  * @see DUTY_CYCLE_WARNING_THRESHOLD
  * @see SLOW_RPM_THRESHOLD
  */
-void update_riding_submode()
+void update_riding_submode(const vesc_telemetry_t *telemetry)
 {
-    float duty_cycle = vesc_serial_get_duty_cycle();
-    int32_t rpm = vesc_serial_get_rpm();
+    int32_t duty_cycle = telemetry->duty_cycle;
+    int32_t rpm = abs(telemetry->rpm);
 
 #ifdef ENABLE_IMU_EVENTS
     if (roll_hysteresis.state == STATE_SET)
@@ -402,7 +390,7 @@ void update_riding_submode()
         }
         // No else required - already in warning submode
     }
-    else if (apply_hysteresis(&slow_rpm_hysteresis, (float)abs(rpm)) == STATE_SET)
+    else if (apply_hysteresis(&slow_rpm_hysteresis, rpm) == STATE_SET)
     {
         if (board_submode != BOARD_SUBMODE_RIDING_NORMAL)
         {
@@ -410,7 +398,7 @@ void update_riding_submode()
         }
         // No else required - already in normal submode
     }
-    else if (apply_hysteresis(&stopped_rpm_hysteresis, (float)abs(rpm)) == STATE_SET)
+    else if (apply_hysteresis(&stopped_rpm_hysteresis, rpm) == STATE_SET)
     {
         if (board_submode != BOARD_SUBMODE_RIDING_SLOW)
         {
@@ -428,36 +416,84 @@ void update_riding_submode()
 }
 
 /**
- * @brief Handles RPM changed events
+ * @brief Handles a change in the VESC fault code
+ *
+ * A non-zero fault code puts the board into VESC fault mode. When the fault
+ * clears, the board returns to active idle.
+ *
+ * @param fault The VESC fault code
+ */
+static void board_mode_vesc_fault_changed(uint8_t fault)
+{
+    if (fault > 0U)
+    {
+        set_board_mode(BOARD_MODE_FAULT, BOARD_SUBMODE_FAULT_VESC);
+    }
+    else
+    {
+        set_board_mode(BOARD_MODE_IDLE, BOARD_SUBMODE_IDLE_ACTIVE);
+    }
+}
+
+#ifdef ENABLE_IMU_EVENTS
+/**
+ * @brief Handles a change in the IMU roll
+ *
+ * Laying the board on its side while idle sends it to dozing, and standing it
+ * back up returns it to active idle.
+ *
+ * @param roll The roll of the board in 0.01 degree units
+ */
+static void board_mode_roll_changed(int16_t roll)
+{
+    if (roll_hysteresis.state != apply_hysteresis(&roll_hysteresis, abs(roll)))
+    {
+        // If the board is on its side, transition to dozing idle mode
+        if (board_mode == BOARD_MODE_IDLE &&
+            (board_submode == BOARD_SUBMODE_IDLE_ACTIVE ||
+             board_submode == BOARD_SUBMODE_IDLE_DEFAULT) &&
+            roll_hysteresis.state == STATE_SET)
+        {
+            set_board_mode(BOARD_MODE_IDLE, BOARD_SUBMODE_IDLE_DOZING);
+        }
+        // If the board is dozing and turned upright, transition to active idle mode
+        else if (board_mode == BOARD_MODE_IDLE && board_submode == BOARD_SUBMODE_IDLE_DOZING &&
+                 roll_hysteresis.state == STATE_RESET)
+        {
+            set_board_mode(BOARD_MODE_IDLE, BOARD_SUBMODE_IDLE_ACTIVE);
+        }
+    }
+}
+#endif // ENABLE_IMU_EVENTS
+
+/**
+ * @brief Handles RPM changes
  *
- * This function processes events related to the RPM changed event. When the
- * RPM changes in the idle mode, the board mode transitions to the riding
- * mode if the RPM is non-zero. Conversely, when the RPM changes in the
+ * When the RPM changes in the idle mode, the board mode transitions to the
+ * riding mode if the RPM is non-zero. Conversely, when the RPM changes in the
  * riding mode, the board mode transitions to the idle mode if the RPM is
- * zero.
+ * zero and nobody is on the footpads.
  *
- * @param event The type of event that occurred, specified as an event_type_t
- *              enumeration
- * @param rpm The new RPM value, specified as a uint32_t
+ * @param telemetry The current telemetry snapshot
  */
-EVENT_HANDLER(board_mode, rpm_changed)
+static void board_mode_rpm_changed(const vesc_telemetry_t *telemetry)
 {
     switch (board_mode)
     {
     case BOARD_MODE_IDLE:
-        if (abs(data->rpm) > 0)
+        if (abs(telemetry->rpm) > 0)
         {
-            update_riding_submode();
+            update_riding_submode(telemetry);
         }
         break;
     case BOARD_MODE_RIDING:
-        if (abs(data->rpm) == 0 && footpads_get_state() == NONE_FOOTPAD)
+        if (abs(telemetry->rpm) == 0 && footpads_get_state() == NONE_FOOTPAD)
         {
             set_board_mode(BOARD_MODE_IDLE, BOARD_SUBMODE_IDLE_ACTIVE);
         }
         else
         {
-            update_riding_submode();
+            update_riding_submode(telemetry);
         }
         break;
     default:
@@ -467,23 +503,42 @@ EVENT_HANDLER(board_mode, rpm_changed)
 }
 
 /**
- * @brief Handles duty cycle changed events
+ * @brief Handles telemetry updates from the VESC
  *
- * This function processes events related to the duty cycle changed event. When
- * the duty cycle changes in the riding mode, the board mode transitions to
- * one of the submodes based on the duty cycle value.
+ * Reads the telemetry snapshot once and reacts to the fields that changed:
+ * the VESC fault code, the IMU roll, and the RPM and duty cycle which drive
+ * the riding submodes.
  *
  * @param event The type of event that occurred, specified as an event_type_t
  *              enumeration
- * @param duty_cycle The new duty cycle value, specified as a float
+ * @param data The event data, containing the mask of changed fields
  */
-EVENT_HANDLER(board_mode, duty_cycle_changed)
+EVENT_HANDLER(board_mode, telemetry_updated)
 {
-    if (board_mode == BOARD_MODE_RIDING)
+    const vesc_telemetry_t *telemetry = vesc_serial_get_telemetry();
+    telemetry_fields_t changed = data->telemetry_changed;
+
+    if (changed & TELEMETRY_FAULT)
     {
-        update_riding_submode();
+        board_mode_vesc_fault_changed(telemetry->fault);
     }
-    // Else: Nothing to do in this mode
+
+#ifdef ENABLE_IMU_EVENTS
+    if (changed & TELEMETRY_IMU_ROLL)
+    {
+        board_mode_roll_changed(telemetry->imu_roll);
+    }
+#endif
+
+    if (changed & TELEMETRY_RPM)
+    {
+        board_mode_rpm_changed(telemetry);
+    }
+    else if ((changed & TELEMETRY_DUTY_CYCLE) && (board_mode == BOARD_MODE_RIDING))
+    {
+        update_riding_submode(telemetry);
+    }
+    // Else: Nothing to do for the other fields
 }
 
 /**
@@ -501,20 +556,20 @@ EVENT_HANDLER(board_mode, fault)
 {
     switch (event)
     {
-        case EVENT_VESC_FAULT_CHANGED:
-            if (data->vesc_fault > 0) {
+        /*
+         * Lost communication with the VESC, transition to VESC fault mode
+         * until it answers again. Any other emergency fault is internal.
+         */
+        case EVENT_EMERGENCY_FAULT:
+            if (data->emergency_fault == EMERGENCY_FAULT_VESC_COMM_TIMEOUT)
+            {
                 set_board_mode(BOARD_MODE_FAULT, BOARD_SUBMODE_FAULT_VESC);
             }
             else
             {
-                set_board_mode(BOARD_MODE_IDLE, BOARD_SUBMODE_IDLE_ACTIVE);
+                set_board_mode(BOARD_MODE_FAULT, BOARD_SUBMODE_FAULT_INTERNAL);
             }
             break;
-        /*
-         * Emergency fault occurred, transition to internal fault mode 
-         */
-        case EVENT_EMERGENCY_FAULT:
-            // Intentional fallthrough 
         default:
             // Unexpected event
             set_board_mode(BOARD_MODE_FAULT, BOARD_SUBMODE_FAULT_INTERNAL);
@@ -545,14 +600,14 @@ EVENT_HANDLER(board_mode, footpad_changed)
             // Rider has stepped on board
             if (data->footpads_state != NONE_FOOTPAD)
             {
-                update_riding_submode();
+                update_riding_submode(vesc_serial_get_telemetry());
             }
         }
         break;
 
     case BOARD_MODE_RIDING:
         // Rider has stepped off board and RPM is zero
-        if (data->footpads_state == NONE_FOOTPAD && vesc_serial_get_rpm() == 0)
+        if (data->footpads_state == NONE_FOOTPAD && vesc_serial_get_telemetry()->rpm == 0)
         {
             set_board_mode(BOARD_MODE_IDLE, BOARD_SUBMODE_IDLE_ACTIVE);
         }
@@ -17,6 +17,7 @@
  * with ALCM. If not, see <https://www.gnu.org/licenses/>.
  */
 #include <stddef.h>
+#include <stdlib.h>
 #include "headlights.h"
 #include "board_mode.h"
 #include "event_queue.h"
@@ -27,9 +28,17 @@
 #include "hysteresis.h"
 #include "vesc_serial.h"
 #include "lcm_types.h"
+#include "tiny_math.h"
 #include "config.h"
 
 #define HEADLIGHTS_TIMER_DELAY 20U // How frequent to update the headlights in ms
+#define HEADLIGHTS_PITCH_CUTOFF 6000 // Pitch (0.01 degrees) beyond which the headlights turn off
+#define HEADLIGHTS_Q15_ONE 32768U    // Control factor of 1.0 in Q15
+
+// Function generators that are running, advanced together by the render timer
+#define HEADLIGHTS_ANIMATING_MODE 0x01U
+#define HEADLIGHTS_ANIMATING_ENABLE 0x02U
+#define HEADLIGHTS_ANIMATING_DIRECTION 0x04U
 
 // Mode animations control the mode control factor
 // and are generally tied to the board mode (i.e., idle, dozing, etc.)
@@ -59,24 +68,45 @@ static settings_t *headlights_settings = NULL;
 static function_generator_t headlights_mode_fg;
 static function_generator_t headlights_enable_fg;
 static function_generator_t headlights_direction_fg;
-static uint32_t headlights_mode_animation_timer_id = INVALID_TIMER_ID;
-static uint32_t headlights_enable_animation_timer_id = INVALID_TIMER_ID;
-static uint32_t headlights_direction_animation_timer_id = INVALID_TIMER_ID;
+static timer_id_t headlights_timer_id = INVALID_TIMER_ID;
+static uint8_t headlights_animating = 0U; // HEADLIGHTS_ANIMATING_* bits
 static hysteresis_t headlights_rpm_hys;
 
-// Control factors
-float enable_control = 1.0f; // Enable control factor
+// Control factors in Q15, the headlights are driven at their product
+static uint16_t brightness_control = HEADLIGHTS_Q15_ONE; // Brightness setting
+static uint16_t enable_control = HEADLIGHTS_Q15_ONE;     // Enable control factor
 #ifdef ENABLE_IMU_EVENTS
-float pitch_control = 1.0f; // Pitch control factor
+static uint16_t pitch_control = HEADLIGHTS_Q15_ONE; // Pitch control factor
 #endif
-float mode_control = 1.0f;  // Mode control factor
-float direction_control = 1.0f; // Direction control factor
+static uint16_t mode_control = HEADLIGHTS_Q15_ONE;      // Mode control factor
+static uint16_t direction_control = HEADLIGHTS_Q15_ONE; // Direction control factor
 
 // Event handlers
 EVENT_HANDLER(headlights, state_change);
-TIMER_CALLBACK(headlights, mode_animation);
-TIMER_CALLBACK(headlights, enable_animation);
-TIMER_CALLBACK(headlights, direction_animation);
+TIMER_CALLBACK(headlights, render);
+
+/**
+ * @brief Converts a control factor from 0.0 to 1.0 to Q15
+ */
+static uint16_t headlights_q15(float value)
+{
+    return (uint16_t)(CLAMP(value, 0.0f, 1.0f) * HEADLIGHTS_Q15_ONE + 0.5f);
+}
+
+/**
+ * @brief Converts the brightness setting to a control factor in Q15
+ *
+ * The setting is the duty cycle at full brightness, whether or not the
+ * perceptual curve is enabled. The factor is the level the hardware maps back
+ * onto that duty cycle, so dimmer levels scale perceptually within it.
+ */
+static uint16_t headlights_brightness_q15(float value)
+{
+    uint32_t duty = ((uint32_t)headlights_q15(value) * HEADLIGHTS_HW_MAX_BRIGHTNESS) >> 15;
+
+    return (uint16_t)(((uint32_t)headlights_hw_lightness((uint16_t)duty) * HEADLIGHTS_Q15_ONE) /
+                      HEADLIGHTS_HW_MAX_BRIGHTNESS);
+}
 
 /**
  * @brief Init the headlights variables and hardware
@@ -86,9 +116,8 @@ lcm_status_t headlights_init(void)
     lcm_status_t status = LCM_SUCCESS;
 
     // Reset variables
-    headlights_mode_animation_timer_id = INVALID_TIMER_ID;
-    headlights_enable_animation_timer_id = INVALID_TIMER_ID;
-    headlights_direction_animation_timer_id = INVALID_TIMER_ID;
+    headlights_timer_id = INVALID_TIMER_ID;
+    headlights_animating = 0U;
 
     // Get the current headlights settings
     headlights_settings = settings_get();
@@ -98,14 +127,15 @@ lcm_status_t headlights_init(void)
     }
     else
     {
-        // Initialize enable control based on settings
+        // Initialize the control factors based on settings
+        brightness_control = headlights_brightness_q15(headlights_settings->headlight_brightness);
         if (headlights_settings->enable_headlights)
         {
-            enable_control = 1.0f;
+            enable_control = HEADLIGHTS_Q15_ONE;
         }
         else
         {
-            enable_control = 0.0f;
+            enable_control = 0U;
         }
 
         // Initialize the hardware
@@ -125,99 +155,139 @@ lcm_status_t headlights_init(void)
 
         // Subscribe to events
         SUBSCRIBE_EVENT(headlights, EVENT_BOARD_MODE_CHANGED, state_change);
-        SUBSCRIBE_EVENT(headlights, EVENT_RPM_CHANGED, state_change);
+        SUBSCRIBE_EVENT(headlights, EVENT_TELEMETRY_UPDATED, state_change);
         SUBSCRIBE_EVENT(headlights, EVENT_COMMAND_TOGGLE_LIGHTS, state_change);
         SUBSCRIBE_EVENT(headlights, EVENT_COMMAND_CONTEXT_CHANGED, state_change);
         SUBSCRIBE_EVENT(headlights, EVENT_COMMAND_SETTINGS_CHANGED, state_change);
+
 #ifdef ENABLE_IMU_EVENTS
-        SUBSCRIBE_EVENT(headlights, EVENT_IMU_PITCH_CHANGED, state_change);
+        // Pitch is used to dim the headlights when the board is picked up
+        vesc_serial_declare_demand(TELEMETRY_IMU_PITCH, BOARD_MODE_MASK(BOARD_MODE_IDLE));
 #endif
     }
 
     return status;
 }
 
-void headlights_set_hw_brightness()
+/**
+ * @brief Composes the control factors and writes the result to the hardware
+ */
+static void headlights_set_hw_brightness(void)
 {
-    uint16_t hw_brightness = 0U;
-    hw_brightness = (uint16_t)
-        (headlights_settings->headlight_brightness *
-         enable_control *
-         pitch_control *
-         mode_control *
-         direction_control *
-         HEADLIGHTS_HW_MAX_BRIGHTNESS
-        );
-    
-    headlights_hw_set_brightness(hw_brightness);
+    uint32_t level = brightness_control;
+
+    level = (level * enable_control) >> 15;
+#ifdef ENABLE_IMU_EVENTS
+    level = (level * pitch_control) >> 15;
+#endif
+    level = (level * mode_control) >> 15;
+    level = (level * direction_control) >> 15;
+
+    headlights_hw_set_brightness((uint16_t)((level * HEADLIGHTS_HW_MAX_BRIGHTNESS) >> 15));
 }
 
-TIMER_CALLBACK(headlights, mode_animation)
+/**
+ * @brief Starts advancing a function generator, starting the render timer if
+ * nothing else is animating
+ *
+ * @param animation The HEADLIGHTS_ANIMATING_* bit of the generator.
+ */
+static void headlights_animate(uint8_t animation)
 {
-    // Get next sample from function generator
-    lcm_status_t status = function_generator_next_sample(&headlights_mode_fg, &mode_control);
-    headlights_set_hw_brightness();
+    headlights_animating |= animation;
 
-    // If function generator is done, cancel timer
-    if (status != LCM_SUCCESS)
+    if (headlights_timer_id == INVALID_TIMER_ID)
     {
-        cancel_timer(headlights_mode_animation_timer_id);
-        headlights_mode_animation_timer_id = INVALID_TIMER_ID;
+        headlights_timer_id =
+            set_timer(HEADLIGHTS_TIMER_DELAY, TIMER_CALLBACK_NAME(headlights, render), true);
     }
 }
 
-TIMER_CALLBACK(headlights, enable_animation)
+/**
+ * @brief Takes the next sample of a function generator as a control factor
+ *
+ * @return True while the generator has more samples.
+ */
+static bool_t headlights_next_sample(function_generator_t *fg, uint16_t *control)
 {
-    // Get next sample from function generator
-    lcm_status_t status = function_generator_next_sample(&headlights_enable_fg, &enable_control);
-    headlights_set_hw_brightness();
+    float sample = 0.0f;
+    lcm_status_t status = function_generator_next_sample(fg, &sample);
+
+    *control = headlights_q15(sample);
 
-    // If function generator is done, cancel timer
-    if (status != LCM_SUCCESS)
+    return (status == LCM_SUCCESS);
+}
+
+/**
+ * @brief Switches direction once the headlights have faded out, then fades
+ * them back in
+ */
+static void headlights_direction_faded(void)
+{
+    // Once the headlights are dark, we can switch directions and start fading back up
+    if (direction_control <= (HEADLIGHTS_Q15_ONE / 10U))
     {
-        cancel_timer(headlights_enable_animation_timer_id);
-        headlights_enable_animation_timer_id = INVALID_TIMER_ID;
+        if (headlights_rpm_hys.state == STATE_SET)
+        {
+            // Set the direction to forward
+            headlights_hw_set_direction(HEADLIGHTS_DIRECTION_FORWARD);
+        }
+        else if (headlights_rpm_hys.state == STATE_RESET)
+        {
+            // Set the direction to reverse
+            headlights_hw_set_direction(HEADLIGHTS_DIRECTION_REVERSE);
+        }
+
+        // Reinitialize the function generator to fade back up
+        function_generator_init(&headlights_direction_fg,
+                                FUNCTION_GENERATOR_SAWTOOTH,
+                                FADE_PERIOD/2,
+                                HEADLIGHTS_TIMER_DELAY,
+                                0.0f,
+                                1.0f,
+                                FG_FLAG_NONE,
+                                0U);
+        headlights_animate(HEADLIGHTS_ANIMATING_DIRECTION);
     }
 }
 
-TIMER_CALLBACK(headlights, direction_animation)
+/**
+ * @brief Advances every running animation and writes the composed brightness
+ *
+ * A single timer drives all of the function generators, so the hardware is
+ * written once per tick however many are running. The timer stops itself once
+ * none are left.
+ */
+TIMER_CALLBACK(headlights, render)
 {
-    // Get next sample from function generator
-    lcm_status_t status = function_generator_next_sample(&headlights_direction_fg, &direction_control);
-    headlights_set_hw_brightness();
-
-    // If function generator is done, cancel timer
-    if (status != LCM_SUCCESS)
+    if (headlights_animating != 0U)
     {
-        cancel_timer(headlights_direction_animation_timer_id);
-        headlights_direction_animation_timer_id = INVALID_TIMER_ID;
+        if (((headlights_animating & HEADLIGHTS_ANIMATING_MODE) != 0U) &&
+            !headlights_next_sample(&headlights_mode_fg, &mode_control))
+        {
+            headlights_animating &= (uint8_t)~HEADLIGHTS_ANIMATING_MODE;
+        }
 
-        // If the direction_control is 0.0f, we can switch directions and start fading back up
-        if (direction_control <= 0.1f)
+        if (((headlights_animating & HEADLIGHTS_ANIMATING_ENABLE) != 0U) &&
+            !headlights_next_sample(&headlights_enable_fg, &enable_control))
         {
-            if (headlights_rpm_hys.state == STATE_SET)
-            {
-                // Set the direction to forward
-                headlights_hw_set_direction(HEADLIGHTS_DIRECTION_FORWARD);
-            }
-            else if (headlights_rpm_hys.state == STATE_RESET)
-            {
-                // Set the direction to reverse
-                headlights_hw_set_direction(HEADLIGHTS_DIRECTION_REVERSE);
-            }
+            headlights_animating &= (uint8_t)~HEADLIGHTS_ANIMATING_ENABLE;
+        }
 
-            // Reinitialize the function generator to fade back up
-            function_generator_init(&headlights_direction_fg,
-                                    FUNCTION_GENERATOR_SAWTOOTH,
-                                    FADE_PERIOD/2,
-                                    HEADLIGHTS_TIMER_DELAY,
-                                    0.0f,
-                                    1.0f,
-                                    FG_FLAG_NONE,
-                                    0U);
-            headlights_direction_animation_timer_id =
-                set_timer(HEADLIGHTS_TIMER_DELAY, TIMER_CALLBACK_NAME(headlights, direction_animation), true);
+        if (((headlights_animating & HEADLIGHTS_ANIMATING_DIRECTION) != 0U) &&
+            !headlights_next_sample(&headlights_direction_fg, &direction_control))
+        {
+            headlights_animating &= (uint8_t)~HEADLIGHTS_ANIMATING_DIRECTION;
+            headlights_direction_faded();
         }
+
+        headlights_set_hw_brightness();
+    }
+
+    if ((headlights_animating == 0U) && (headlights_timer_id != INVALID_TIMER_ID))
+    {
+        cancel_timer(headlights_timer_id);
+        headlights_timer_id = INVALID_TIMER_ID;
     }
 }
 
@@ -252,7 +322,7 @@ void headlights_set_mode_animation(headlights_mode_animation_t animation)
                                 FUNCTION_GENERATOR_SINE,
                                 SLOW_BREATH_PERIOD,
                                 HEADLIGHTS_TIMER_DELAY,
-                                0.05f,
+                                HEADLIGHTS_DOZING_BRIGHTNESS,
                                 HEADLIGHTS_IDLE_BRIGHTNESS,
                                 FG_FLAG_REPEAT,
                                 0U);
@@ -288,18 +358,13 @@ void headlights_set_mode_animation(headlights_mode_animation_t animation)
 
     if (animation == HEADLIGHTS_MODE_ANIMATION_NONE)
     {
-        // Stop the animation
-        if (headlights_mode_animation_timer_id != INVALID_TIMER_ID)
-        {
-            cancel_timer(headlights_mode_animation_timer_id);
-            headlights_mode_animation_timer_id = INVALID_TIMER_ID;
-            headlights_set_hw_brightness();
-        }
+        // Stop the animation, the render timer stops itself if nothing else
+        // is running
+        headlights_animating &= (uint8_t)~HEADLIGHTS_ANIMATING_MODE;
     }
     else
     {
-        headlights_mode_animation_timer_id =
-            set_timer(HEADLIGHTS_TIMER_DELAY, TIMER_CALLBACK_NAME(headlights, mode_animation), true);
+        headlights_animate(HEADLIGHTS_ANIMATING_MODE);
     }
 }
 
@@ -317,22 +382,17 @@ void headlights_set_enable_animation(headlights_enable_animation_t animation)
                                 FG_FLAG_INVERT,
                                 0U);
 
-        headlights_enable_animation_timer_id =
-            set_timer(HEADLIGHTS_TIMER_DELAY, TIMER_CALLBACK_NAME(headlights, enable_animation), true);
+        headlights_animate(HEADLIGHTS_ANIMATING_ENABLE);
     } else {
         // Stop the animation
-        if (headlights_enable_animation_timer_id != INVALID_TIMER_ID)
-        {
-            cancel_timer(headlights_enable_animation_timer_id);
-            headlights_enable_animation_timer_id = INVALID_TIMER_ID;
-        }
+        headlights_animating &= (uint8_t)~HEADLIGHTS_ANIMATING_ENABLE;
     }
 }    
 
-void headlights_rpm_changed(void)
+void headlights_rpm_changed(int32_t rpm)
 {
     // ERPM is used to determine direction
-    hys_state_t state = apply_hysteresis(&headlights_rpm_hys, (float)vesc_serial_get_rpm());
+    hys_state_t state = apply_hysteresis(&headlights_rpm_hys, rpm);
     headlights_direction_t direction = headlights_hw_get_direction();
     if ((state == STATE_SET && direction != HEADLIGHTS_DIRECTION_FORWARD) ||
         (state == STATE_RESET && direction != HEADLIGHTS_DIRECTION_REVERSE))
@@ -346,31 +406,69 @@ void headlights_rpm_changed(void)
                                 1.0f,
                                 FG_FLAG_INVERT,
                                 0U);
-        function_generator_initial_sample(&headlights_direction_fg, direction_control);
-        headlights_direction_animation_timer_id =
-            set_timer(HEADLIGHTS_TIMER_DELAY, TIMER_CALLBACK_NAME(headlights, direction_animation), true);
+        function_generator_initial_sample(&headlights_direction_fg,
+                                          (float)direction_control / HEADLIGHTS_Q15_ONE);
+        headlights_animate(HEADLIGHTS_ANIMATING_DIRECTION);
     }
 }
 
+/**
+ * @brief Reacts to the telemetry fields the headlights care about
+ *
+ * @param changed Mask of the telemetry fields that changed
+ */
+void headlights_telemetry_updated(telemetry_fields_t changed)
+{
+    const vesc_telemetry_t *telemetry = vesc_serial_get_telemetry();
+
+    if (changed & TELEMETRY_RPM)
+    {
+        headlights_rpm_changed(telemetry->rpm);
+    }
+
+#ifdef ENABLE_IMU_EVENTS
+    if (changed & TELEMETRY_IMU_PITCH)
+    {
+        // Update the pitch control factor based on the IMU pitch
+        if (abs(telemetry->imu_pitch) >= HEADLIGHTS_PITCH_CUTOFF)
+        {
+            pitch_control = 0U;
+        }
+        else
+        {
+            pitch_control = HEADLIGHTS_Q15_ONE;
+        }
+    }
+#endif
+}
+
 EVENT_HANDLER(headlights, state_change)
 {
     switch (event)
     {
     // Handle headlight conditions related to board mode
     case EVENT_BOARD_MODE_CHANGED:
+#ifdef ENABLE_IMU_EVENTS
+        // Pitch is only polled while idle, so don't let the last reading keep
+        // the headlights dark in any other mode
+        if (data->board_mode.mode != BOARD_MODE_IDLE)
+        {
+            pitch_control = HEADLIGHTS_Q15_ONE;
+        }
+#endif
         switch (board_mode_get())
         {
         case BOARD_MODE_BOOTING:
             headlights_hw_set_direction(HEADLIGHTS_DIRECTION_FORWARD);
             // Fall through intentional
         case BOARD_MODE_RIDING:
-            mode_control = 1.0f;
+            mode_control = HEADLIGHTS_Q15_ONE;
             headlights_set_mode_animation(HEADLIGHTS_MODE_ANIMATION_NONE);
             break;
         case BOARD_MODE_CHARGING:
             // Fall through intentional
         case BOARD_MODE_OFF:
-            mode_control = 0.0f;
+            mode_control = 0U;
             headlights_set_mode_animation(HEADLIGHTS_MODE_ANIMATION_NONE);
             break;
         case BOARD_MODE_FAULT:
@@ -390,7 +488,7 @@ EVENT_HANDLER(headlights, state_change)
             case BOARD_SUBMODE_IDLE_CONFIG:
                 // Fall through intentional
             case BOARD_SUBMODE_IDLE_ACTIVE:
-                mode_control = 1.0f;
+                mode_control = HEADLIGHTS_Q15_ONE;
                 headlights_set_mode_animation(HEADLIGHTS_MODE_ANIMATION_NONE);
                 break;
             case BOARD_SUBMODE_IDLE_DEFAULT:
@@ -416,15 +514,15 @@ EVENT_HANDLER(headlights, state_change)
             break;
         }
         break;
-    // Handle RPM changes (direction)
-    case EVENT_RPM_CHANGED:
-        headlights_rpm_changed();
+    // Handle RPM (direction) and pitch changes
+    case EVENT_TELEMETRY_UPDATED:
+        headlights_telemetry_updated(data->telemetry_changed);
         break;
     // Enable/disable headlights
     case EVENT_COMMAND_TOGGLE_LIGHTS:
         if (headlights_settings->enable_headlights)
         {
-            enable_control = 1.0f;
+            enable_control = HEADLIGHTS_Q15_ONE;
             headlights_set_enable_animation(HEADLIGHTS_ENABLE_ANIMATION_NONE);
         }
         else
@@ -443,23 +541,15 @@ EVENT_HANDLER(headlights, state_change)
             headlights_set_mode_animation(HEADLIGHTS_MODE_ANIMATION_NONE);
         }
         break;
-#ifdef ENABLE_IMU_EVENTS
-    case EVENT_IMU_PITCH_CHANGED:
-        // Update the pitch control factor based on the IMU pitch
-        {
-            if (data->imu_pitch >= 60.0f || data->imu_pitch <= -60.0f) {
-                pitch_control = 0.0f;
-            } else {
-                pitch_control = 1.0f;
-            }
-        }
+    // Pick up a new brightness setting, converted here so the telemetry path
+    // stays free of floating point
+    case EVENT_COMMAND_SETTINGS_CHANGED:
+        brightness_control = headlights_brightness_q15(headlights_settings->headlight_brightness);
         break;
-#endif
     default:
         // Nothing to do
         break;
     }
 
-    // Update the brightness setting
     headlights_set_hw_brightness();
 }
\ No newline at end of file
@@ -18,6 +18,62 @@
  */
 #include "headlights_hw.h"
 #include "hk32f030m.h"
+#include "config.h"
+
+#ifdef ENABLE_HEADLIGHTS_CIE
+/**
+ * @brief Number of linear brightness steps between two entries of the curve
+ */
+#define HEADLIGHTS_CIE_STEP_BITS 6U
+
+/**
+ * @brief CIE 1931 lightness curve, the duty cycle (Q16) that looks L/64 as
+ * bright as full, for L = 0 to 64
+ *
+ * Equal brightness steps look equally large, so fades are even across the
+ * whole range instead of rushing through the dim end. Values in between are
+ * interpolated.
+ */
+static const uint16_t headlights_cie_table[(HEADLIGHTS_HW_MAX_BRIGHTNESS >>
+                                            HEADLIGHTS_CIE_STEP_BITS) + 1U] = {
+    0, 113, 227, 340, 453, 567, 686, 821, 972, 1141, 1328,
+    1535, 1762, 2010, 2281, 2575, 2894, 3237, 3607, 4004, 4429, 4883,
+    5367, 5882, 6429, 7009, 7623, 8272, 8956, 9677, 10436, 11234, 12071,
+    12949, 13868, 14830, 15835, 16885, 17980, 19121, 20310, 21547, 22834, 24170,
+    25558, 26998, 28491, 30038, 31640, 33297, 35012, 36785, 38617, 40508, 42460,
+    44474, 46551, 48691, 50896, 53166, 55503, 57908, 60381, 62923, 65535};
+#endif
+
+#ifdef ENABLE_HEADLIGHTS_DITHER
+/**
+ * @brief Fractional bits of the compare value carried by the dither
+ *
+ * The slowest pattern repeats every 2^bits PWM periods, so 4 bits keeps it
+ * above 60 Hz at the 1 kHz PWM frequency while adding 16 levels per step.
+ */
+#define HEADLIGHTS_DITHER_BITS 4U
+#define HEADLIGHTS_DITHER_MASK ((1U << HEADLIGHTS_DITHER_BITS) - 1U)
+
+// Compare value with HEADLIGHTS_DITHER_BITS fractional bits, written in one store
+static volatile uint32_t headlights_dither_level = 0U;
+
+// Fraction of a count owed by the previous periods
+static uint8_t headlights_dither_error = 0U;
+
+#ifdef ENABLE_HEADLIGHTS_BENCHMARK
+/**
+ * @brief Longest run of the dither interrupt in core cycles, not counting the
+ * 16 or so cycles of interrupt entry and exit. Read it with the debugger.
+ */
+volatile uint32_t headlights_hw_dither_cycles = 0U;
+
+/**
+ * @brief CPU load of the dither interrupt at its longest, in parts per
+ * million. The interrupt runs once per TIM1 period.
+ */
+volatile uint32_t headlights_hw_dither_load_ppm = 0U;
+#endif
+#endif
 
 /**
  * @brief Initializes the headlights hardware module.
@@ -58,6 +114,23 @@ void headlights_hw_init(void)
     TIM_OCInitStructure.TIM_OCNIdleState = TIM_OCIdleState_Reset;
     TIM_OC2Init(TIM1, &TIM_OCInitStructure);
 
+#ifdef ENABLE_HEADLIGHTS_DITHER
+    {
+        NVIC_InitTypeDef NVIC_InitStructure = {0};
+
+        // The compare value is changed every period, so it is buffered until
+        // the next update instead of racing the counter
+        TIM_OC2PreloadConfig(TIM1, TIM_OCPreload_Enable);
+        TIM_ITConfig(TIM1, TIM_IT_Update, ENABLE);
+
+        // Lowest priority, a late update only delays the dither by a period
+        NVIC_InitStructure.NVIC_IRQChannel = TIM1_UP_TRG_COM_IRQn;
+        NVIC_InitStructure.NVIC_IRQChannelPriority = 3;
+        NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+        NVIC_Init(&NVIC_InitStructure);
+    }
+#endif
+
     // PC7 is used moving forward (white front, red rear)
     GPIO_InitStructure.GPIO_Mode = GPIO_Mode_OUT;
     GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
@@ -148,23 +221,116 @@ headlights_direction_t headlights_hw_get_direction(void)
  *
  * This function adjusts the pulse width modulation (PWM) signal to set
  * the desired brightness level for the headlights. The brightness value
- * is clamped to the maximum allowable value defined by TIM1_PERIOD, and
- * the PWM compare value is updated only if the headlights are enabled.
+ * is clamped to HEADLIGHTS_HW_MAX_BRIGHTNESS and mapped onto TIM1_PERIOD,
+ * through the CIE lightness curve when it is enabled. TIM1_PERIOD is a power
+ * of two, so the scaling is a shift.
+ *
+ * With dithering the fraction of a count left over is kept, and the update
+ * interrupt spreads it across PWM periods.
  *
  * @param brightness The desired brightness level, ranging from 0 to
- * TIM1_PERIOD.
+ * HEADLIGHTS_HW_MAX_BRIGHTNESS.
  */
 
 void headlights_hw_set_brightness(uint16_t brightness)
 {
-    uint32_t compareValue = 0U;
+    uint32_t level = 0U; // Compare value in Q16
 
     // Ensure brightness is within the expected range
-    if (brightness > TIM1_PERIOD)
+    if (brightness > HEADLIGHTS_HW_MAX_BRIGHTNESS)
+    {
+        brightness = HEADLIGHTS_HW_MAX_BRIGHTNESS;
+    }
+
+#ifdef ENABLE_HEADLIGHTS_CIE
+    {
+        const uint16_t index = brightness >> HEADLIGHTS_CIE_STEP_BITS;
+        const uint32_t fraction = brightness & ((1U << HEADLIGHTS_CIE_STEP_BITS) - 1U);
+        uint32_t duty = headlights_cie_table[index];
+
+        if (fraction != 0U)
+        {
+            duty += ((headlights_cie_table[index + 1U] - duty) * fraction) >>
+                    HEADLIGHTS_CIE_STEP_BITS;
+        }
+
+        level = duty * TIM1_PERIOD;
+    }
+#else
+    level = ((uint32_t)brightness * TIM1_PERIOD) * (65536U / HEADLIGHTS_HW_MAX_BRIGHTNESS);
+#endif
+
+    // Rounded, so the top of the curve is fully on
+#ifdef ENABLE_HEADLIGHTS_DITHER
+    headlights_dither_level =
+        (level + (0x8000U >> HEADLIGHTS_DITHER_BITS)) >> (16U - HEADLIGHTS_DITHER_BITS);
+#else
+    TIM_SetCompare2(TIM1, (level + 0x8000U) >> 16U);
+#endif
+}
+
+uint16_t headlights_hw_lightness(uint16_t duty)
+{
+    if (duty > HEADLIGHTS_HW_MAX_BRIGHTNESS)
+    {
+        duty = HEADLIGHTS_HW_MAX_BRIGHTNESS;
+    }
+
+#ifdef ENABLE_HEADLIGHTS_CIE
     {
-        brightness = TIM1_PERIOD;
+        // Duty cycle in Q16, capped so full scale matches the last entry
+        const uint32_t target = ((uint32_t)duty * 65535U) / HEADLIGHTS_HW_MAX_BRIGHTNESS;
+        uint16_t index = 0U;
+        uint32_t fraction = 0U;
+
+        // Find the step of the curve the duty cycle falls in, the curve is
+        // only inverted when the setting changes so a linear search will do
+        while ((index < ((HEADLIGHTS_HW_MAX_BRIGHTNESS >> HEADLIGHTS_CIE_STEP_BITS) - 1U)) &&
+               (headlights_cie_table[index + 1U] <= target))
+        {
+            index++;
+        }
+
+        fraction = ((target - headlights_cie_table[index]) << HEADLIGHTS_CIE_STEP_BITS) /
+                   (uint32_t)(headlights_cie_table[index + 1U] - headlights_cie_table[index]);
+        duty = (uint16_t)((index << HEADLIGHTS_CIE_STEP_BITS) + fraction);
     }
+#endif
+
+    return duty;
+}
 
-    compareValue = (brightness * TIM1_PERIOD) / TIM1_PERIOD;
-    TIM_SetCompare2(TIM1, compareValue);
-}
\ No newline at end of file
+#ifdef ENABLE_HEADLIGHTS_DITHER
+/**
+ * @brief TIM1 update interrupt, sets the compare value for the next period.
+ *
+ * First order sigma-delta: the fraction is added to an error accumulator each
+ * period, and the period gets one extra count whenever it carries. Over
+ * 2^HEADLIGHTS_DITHER_BITS periods the average is the exact level.
+ */
+void headlights_hw_tim1_irq(void)
+{
+#ifdef ENABLE_HEADLIGHTS_BENCHMARK
+    const uint32_t start = SysTick->VAL;
+    uint32_t end = 0U;
+    uint32_t cycles = 0U;
+#endif
+    const uint32_t level = headlights_dither_level;
+    const uint8_t sum = headlights_dither_error + (uint8_t)(level & HEADLIGHTS_DITHER_MASK);
+
+    TIM1->SR = (uint16_t)~TIM_SR_UIF;
+    headlights_dither_error = sum & HEADLIGHTS_DITHER_MASK;
+    TIM1->CCR2 = (level >> HEADLIGHTS_DITHER_BITS) + (sum >> HEADLIGHTS_DITHER_BITS);
+
+#ifdef ENABLE_HEADLIGHTS_BENCHMARK
+    // SysTick counts down, and wraps every millisecond
+    end = SysTick->VAL;
+    cycles = (start >= end) ? (start - end) : (start + SysTick->LOAD + 1U - end);
+    if (cycles > headlights_hw_dither_cycles)
+    {
+        headlights_hw_dither_cycles = cycles;
+        headlights_hw_dither_load_ppm = (cycles * 1000000U) / (TIM1_PRESCALER * TIM1_PERIOD);
+    }
+#endif
+}
+#endif
@@ -19,6 +19,8 @@
 #include "event_queue.h"
 #include "timer.h"
 #include "vesc_serial.h"
+#include "status_leds_hw.h"
+#include "headlights_hw.h"
 #include "config.h"
 
 /* USER CODE END Includes */
@@ -152,6 +154,32 @@ void EXTI3_IRQHandler(void)
     }
 }
 
+#ifdef ENABLE_STATUS_LEDS_SPI
+/**
+ * @brief SPI1 Interrupt Request Handler
+ *
+ * Only the TXE interrupt is used, to feed the status LED frame to the SPI
+ * transmit FIFO (see status_leds_hw.c).
+ */
+void SPI1_IRQHandler(void)
+{
+    status_leds_hw_spi_irq();
+}
+#endif
+
+#ifdef ENABLE_HEADLIGHTS_DITHER
+/**
+ * @brief TIM1 Update Interrupt Request Handler
+ *
+ * Runs once per headlight PWM period to dither the compare value (see
+ * headlights_hw.c).
+ */
+void TIM1_UP_TRG_COM_IRQHandler(void)
+{
+    headlights_hw_tim1_irq();
+}
+#endif
+
 static ring_buffer_t *usart_rx_buffer = NULL;
 /**
  * @brief USART1 Interrupt Request Handler
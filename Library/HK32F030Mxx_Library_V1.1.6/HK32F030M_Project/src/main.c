@@ -116,6 +116,12 @@ int main(void)
             // Error processing the event queue
             fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
         }
+
+#ifdef ENABLE_STATUS_LEDS
+        // Send at most one status LED frame per pass, after every event
+        // handler has had a chance to draw
+        status_leds_flush();
+#endif
     }
 
     // Never reached
@@ -22,6 +22,7 @@
 #include "crc16_ccitt.h"
 #include "eeprom.h"
 #include "event_queue.h"
+#include "tiny_math.h"
 
 /**
  * @brief      Magic number to identify valid settings.
@@ -30,7 +31,7 @@
  *             If the magic number in the settings does not match this value, the
  *             settings are considered invalid and will be reset to default values.
  */
-#define MAGIC_NUMBER 0xbeef0001
+#define MAGIC_NUMBER 0xbeef0005
 
 /**
  * @brief      Structure to represent the settings in the EEPROM.
@@ -41,6 +42,36 @@ typedef struct
     uint16_t crc;        // CRC
 } settings_eeprom_t;
 
+#ifdef ENABLE_CUSTOM_ANIMATIONS
+/**
+ * @brief      Default contents of the custom animation slots.
+ *
+ * @details    A personal color "breathing" fill and a scan that drifts
+ *             through the hues next to the personal color.
+ */
+static const animation_params_t default_custom_animations[CUSTOM_ANIMATION_COUNT] = {
+    {.type = ANIMATION_TYPE_FILL,
+     .flags = ANIMATION_FLAG_PERSONAL_RGB,
+     .mode = FILL_MODE_SOLID,
+     .color_mode = COLOR_MODE_RGB,
+     .brightness_mode = BRIGHTNESS_MODE_SINE,
+     .brightness_min = 16U,
+     .brightness_max = 255U,
+     .brightness_speed = 4000U},
+    {.type = ANIMATION_TYPE_SCAN,
+     .flags = ANIMATION_FLAG_PERSONAL_HUE,
+     .mode = SCAN_DIRECTION_SINE,
+     .color_mode = COLOR_MODE_HSV_SINE,
+     .period = 3000U,
+     .sigma = 120U,
+     .hue_min = -30,
+     .hue_max = 30,
+     .color_speed = 6000U,
+     .scan_end = SCAN_END_NEVER,
+     .modulation = ANIMATION_MOD_SPEED},
+};
+#endif
+
 static settings_eeprom_t eeprom = {0};
 static bool_t settings_loaded = false;
 
@@ -73,6 +104,12 @@ void settings_reset(void)
     eeprom.settings.headlight_brightness = 0.8f;
     eeprom.settings.status_brightness = 0.8f;
     eeprom.settings.personal_color = 200.0f; // Light blue
+    eeprom.settings.status_leds_strips[0].count = MIN(10U, STATUS_LEDS_MAX_COUNT); // Stock strip
+    eeprom.settings.status_leds_strips[0].order = STATUS_LEDS_ORDER_GRB;
+#ifdef ENABLE_CUSTOM_ANIMATIONS
+    memcpy(eeprom.settings.custom_animations, default_custom_animations,
+           sizeof(eeprom.settings.custom_animations));
+#endif
 
     // Save
     settings_save();
@@ -109,7 +146,8 @@ bool_t settings_range_check(void)
     else if (eeprom.settings.boot_animation >= ANIMATION_OPTION_COUNT ||
              eeprom.settings.idle_animation >= ANIMATION_OPTION_COUNT ||
              eeprom.settings.dozing_animation >= ANIMATION_OPTION_COUNT ||
-             eeprom.settings.shutdown_animation >= ANIMATION_OPTION_COUNT)
+             eeprom.settings.shutdown_animation >= ANIMATION_OPTION_COUNT ||
+             eeprom.settings.ride_animation >= ANIMATION_OPTION_COUNT)
     {
         valid = false;
     }
@@ -125,6 +163,22 @@ bool_t settings_range_check(void)
     {
         valid = false;
     }
+    else if (status_leds_strips_count(eeprom.settings.status_leds_strips) == 0U)
+    {
+        valid = false;
+    }
+#ifdef ENABLE_CUSTOM_ANIMATIONS
+    else
+    {
+        for (uint8_t i = 0U; i < CUSTOM_ANIMATION_COUNT; i++)
+        {
+            if (!animation_params_valid(&eeprom.settings.custom_animations[i]))
+            {
+                valid = false;
+            }
+        }
+    }
+#endif
 
     return valid;
 }
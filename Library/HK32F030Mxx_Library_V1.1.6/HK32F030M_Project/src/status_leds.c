@@ -27,6 +27,7 @@
 #include "settings.h"
 #include "tiny_math.h"
 #include "board_mode.h"
+#include "crc16_ccitt.h"
 #include "config.h"
 
 /**
@@ -45,28 +46,123 @@ typedef struct
 } color_palette_t;
 
 // Color palette
-// Note: format is {G, R, B}
 static const color_palette_t colors = {.black = {0x00, 0x00, 0x00},
                                        .white = {0xff, 0xff, 0xff},
-                                       .red = {0x00, 0xff, 0x00},
-                                       .orange = {0x7f, 0xff, 0x00},
-                                       .green = {0xff, 0x00, 0x00},
+                                       .red = {0xff, 0x00, 0x00},
+                                       .orange = {0xff, 0x7f, 0x00},
+                                       .green = {0x00, 0xff, 0x00},
                                        .blue = {0x00, 0x00, 0xff},
-                                       .magenta = {0x00, 0xff, 0xff},
-                                       .light_blue = {0x77, 0x00, 0xb6}};
+                                       .magenta = {0xff, 0x00, 0xff},
+                                       .light_blue = {0x00, 0x77, 0xb6}};
 
-// Status LED buffer
-static status_leds_color_t status_leds_buffer[STATUS_LEDS_COUNT] = {0};
+// Status LED buffer, sized for the longest strip the build supports
+static status_leds_color_t status_leds_buffer[STATUS_LEDS_MAX_COUNT] = {0};
+static uint8_t status_leds_count = STATUS_LEDS_MAX_COUNT;
 static settings_t *status_leds_settings = NULL;
 static status_leds_color_t custom_color;
 static uint16_t battery_animation_id = 0U;
 static uint16_t ride_animation_id = 0U;
+static uint8_t status_leds_modulation = ANIMATION_MOD_NONE; // Bindings of the running animation
+
+// Refresh requests are coalesced and sent once per event loop pass, and only
+// if the frame differs from the one last sent to the strip.
+static bool_t status_leds_refresh_pending = false;
+static bool_t status_leds_frame_valid = false;
+static uint16_t status_leds_frame_crc = 0U;
+
+/**
+ * @brief How an overlay layer is combined with the layers below it
+ */
+typedef enum
+{
+    STATUS_LEDS_BLEND_REPLACE, // Layer pixels replace the ones below
+    STATUS_LEDS_BLEND_ALPHA,   // Mixed with the pixels below by the layer alpha
+    STATUS_LEDS_BLEND_ADD      // Added to the pixels below, saturating
+} status_leds_blend_t;
+
+/**
+ * @brief Overlay layers, from the bottom up
+ */
+typedef enum
+{
+    STATUS_LEDS_LAYER_BATTERY,   // Battery gauge
+    STATUS_LEDS_LAYER_FOOTPAD,   // Footpad indicator
+    STATUS_LEDS_LAYER_ALERT,     // Critical battery flash
+    STATUS_LEDS_LAYER_CROSSFADE, // Last frame of the previous mode, fading out
+    STATUS_LEDS_LAYER_COUNT
+} status_leds_layer_id_t;
+
+/**
+ * @brief An overlay drawn on top of the animation buffer
+ */
+typedef struct
+{
+    status_leds_color_t pixels[STATUS_LEDS_MAX_COUNT]; // Layer contents
+    uint8_t first_led;                                 // First LED covered by the layer
+    uint8_t last_led;                                  // Last LED covered, clipped to the strip
+    status_leds_blend_t blend;                         // How the layer is combined
+    uint8_t alpha;                                     // Opacity for STATUS_LEDS_BLEND_ALPHA
+    bool_t visible;                                    // Whether the layer is composed
+} status_leds_layer_t;
+
+// The animation buffer is the base layer. Overlays keep their contents while
+// hidden and are only redrawn when what they show changes, then everything is
+// composed into the frame sent to the strip once per event loop pass.
+static status_leds_layer_t status_leds_layers[STATUS_LEDS_LAYER_COUNT] = {
+    [STATUS_LEDS_LAYER_BATTERY] = {.first_led = 0U,
+                                   .last_led = STATUS_LEDS_MAX_COUNT - 1U,
+                                   .blend = STATUS_LEDS_BLEND_REPLACE,
+                                   .alpha = 255U},
+    [STATUS_LEDS_LAYER_FOOTPAD] = {.first_led = 0U,
+                                   .last_led = STATUS_LEDS_MAX_COUNT - 1U,
+                                   .blend = STATUS_LEDS_BLEND_REPLACE,
+                                   .alpha = 255U},
+    [STATUS_LEDS_LAYER_ALERT] = {.first_led = 0U,
+                                 .last_led = 0U,
+                                 .blend = STATUS_LEDS_BLEND_ADD,
+                                 .alpha = 255U},
+    [STATUS_LEDS_LAYER_CROSSFADE] = {.first_led = 0U,
+                                     .last_led = STATUS_LEDS_MAX_COUNT - 1U,
+                                     .blend = STATUS_LEDS_BLEND_ALPHA,
+                                     .alpha = 255U},
+};
+
+// Composed frame. status_leds_hw_refresh encodes it into its own wire buffer
+// before it returns, so the next frame can be composed here while the last
+// one is still going out.
+static status_leds_color_t status_leds_frame[STATUS_LEDS_MAX_COUNT] = {0};
+
+/**
+ * @brief Retained state of the battery gauge drawn in the battery layer
+ *
+ * The level is quantized to a quarter of an LED, so battery level changes
+ * that would not move the edge of the bar do not redraw it.
+ */
+typedef struct
+{
+    int16_t segment;                  // Drawn level in segments, or BATTERY_GAUGE_NOT_DRAWN
+    const status_leds_color_t *color; // Drawn color
+} battery_gauge_t;
+
+#define BATTERY_GAUGE_FULL_LEVEL 1000     // Battery level (0.1%) that lights the whole strip
+#define BATTERY_GAUGE_SEGMENTS_PER_LED 4   // Segments the gauge moves in per LED
+#define BATTERY_GAUGE_HYSTERESIS 3         // Battery level (0.1%) past a segment edge to move
+#define BATTERY_GAUGE_NOT_DRAWN INT16_MIN
+
+// What the battery and footpad layers currently hold
+#define STATUS_LEDS_FOOTPAD_NOT_DRAWN 0xFFU
+static battery_gauge_t battery_gauge = {.segment = BATTERY_GAUGE_NOT_DRAWN, .color = NULL};
+static uint8_t footpad_layer_state = STATUS_LEDS_FOOTPAD_NOT_DRAWN;
 
 // Forward declarations
 EVENT_HANDLER(status_leds, state_changed);
+EVENT_HANDLER(status_leds, telemetry_updated);
 EVENT_HANDLER(status_leds, command);
 void status_leds_turn_off(void);
 void update_display(event_type_t event);
+#ifdef ENABLE_STATUS_LEDS_BENCHMARK
+static void status_leds_benchmark(void);
+#endif
 
 /**
  * @brief Initializes the status LEDs module.
@@ -89,12 +185,21 @@ lcm_status_t status_leds_init(void)
     else
     {
         // Initialize the hardware
-        status_leds_hw_init(status_leds_buffer);
+        status_leds_count = status_leds_strips_count(status_leds_settings->status_leds_strips);
+        status_leds_hw_init();
+        status_leds_hw_set_strips(status_leds_settings->status_leds_strips);
 
         // Configure brightness
         status_leds_hw_set_brightness(status_leds_settings->status_brightness);
 
-        // Force LEDs off
+        // Force LEDs off, the first frame is always sent
+        status_leds_frame_valid = false;
+        for (uint8_t i = 0; i < STATUS_LEDS_LAYER_COUNT; i++)
+        {
+            status_leds_layers[i].visible = false;
+        }
+        battery_gauge.segment = BATTERY_GAUGE_NOT_DRAWN;
+        footpad_layer_state = STATUS_LEDS_FOOTPAD_NOT_DRAWN;
         status_leds_turn_off();
         status_leds_hw_enable(status_leds_settings->enable_status_leds);
 
@@ -104,220 +209,511 @@ lcm_status_t status_leds_init(void)
 
         // Subscribe to events that trigger status changes
         //
-        // Note: We don't subscribe to RPM or duty cycle here because they are
-        // handled by the board state machine.
+        // Note: Telemetry updates carry the battery level, which drives the
+        // display, and the RPM and duty cycle, which drive the animation
+        // modulation. Mode changes caused by them come from the board state
+        // machine.
         SUBSCRIBE_EVENT(status_leds, EVENT_BOARD_MODE_CHANGED, state_changed);
         SUBSCRIBE_EVENT(status_leds, EVENT_FOOTPAD_CHANGED, state_changed);
-        SUBSCRIBE_EVENT(status_leds, EVENT_BATTERY_LEVEL_CHANGED, state_changed);
+        SUBSCRIBE_EVENT(status_leds, EVENT_TELEMETRY_UPDATED, telemetry_updated);
         SUBSCRIBE_EVENT(status_leds, EVENT_COMMAND_TOGGLE_LIGHTS, command);
         SUBSCRIBE_EVENT(status_leds, EVENT_COMMAND_TOGGLE_BEEPER, command);
         SUBSCRIBE_EVENT(status_leds, EVENT_COMMAND_CONTEXT_CHANGED, command);
         SUBSCRIBE_EVENT(status_leds, EVENT_COMMAND_SETTINGS_CHANGED, command);
+
+#ifdef ENABLE_STATUS_LEDS_BENCHMARK
+        status_leds_benchmark();
+#endif
+
+#ifdef ENABLE_IMU_EVENTS
+        // Roll picks the animation direction. Animations that start when
+        // leaving idle use the last reading taken while idle.
+        vesc_serial_declare_demand(TELEMETRY_IMU_ROLL, BOARD_MODE_MASK(BOARD_MODE_IDLE));
+#endif
     }
 
     return status;
 }
 
-uint16_t status_leds_start_animation_option(animation_option_t option)
+/**
+ * @brief Built-in animations, indexed by animation_option_t
+ *
+ * Each entry is a parameter block interpreted by
+ * status_leds_start_animation_params(), so an animation costs a table entry
+ * rather than its own code.
+ */
+static const animation_params_t builtin_animations[ANIMATION_OPTION_COUNT] = {
+    [ANIMATION_OPTION_NONE] = {.type = ANIMATION_TYPE_FADE,
+                               .period = STATUS_LEDS_FADE_TO_BLACK_TIMEOUT},
+    [ANIMATION_OPTION_RAINBOW_SCAN] = {.type = ANIMATION_TYPE_SCAN,
+                                       .mode = SCAN_DIRECTION_SINE,
+                                       .color_mode = COLOR_MODE_HSV_DECREASE,
+                                       .period = STATUS_LEDS_SCAN_SPEED,
+                                       .sigma = 70U,
+                                       .hue_min = 0,
+                                       .hue_max = 360,
+                                       .color_speed = 3000U,
+                                       .scan_end = SCAN_END_NEVER,
+                                       .modulation = ANIMATION_MOD_SPEED},
+    [ANIMATION_OPTION_RAINBOW_MIRROR] = {.type = ANIMATION_TYPE_FILL,
+                                         .mode = FILL_MODE_HSV_GRADIENT_MIRROR,
+                                         .color_mode = COLOR_MODE_HSV_INCREASE,
+                                         .brightness_mode = BRIGHTNESS_MODE_STATIC,
+                                         .hue_min = 0,
+                                         .hue_max = 360,
+                                         .color_speed = 1500U,
+                                         .brightness_min = 0U,
+                                         .brightness_max = 255U},
+#ifdef ENABLE_KNIGHT_RIDER_ANIMATION
+    [ANIMATION_OPTION_KNIGHT_RIDER] = {.type = ANIMATION_TYPE_SCAN,
+                                       .mode = SCAN_DIRECTION_SINE,
+                                       .color_mode = COLOR_MODE_RGB,
+                                       .period = STATUS_LEDS_SCAN_SPEED,
+                                       .sigma = 70U,
+                                       .scan_end = SCAN_END_NEVER,
+                                       .modulation = ANIMATION_MOD_SPEED,
+                                       .rgb = {0xff, 0x00, 0x00}}, // Red
+#endif
+    [ANIMATION_OPTION_RAINBOW_BAR] = {.type = ANIMATION_TYPE_FILL,
+                                      .flags = ANIMATION_FLAG_FOLLOW_ROLL,
+                                      .mode = FILL_MODE_HSV_GRADIENT,
+                                      .color_mode = COLOR_MODE_HSV_INCREASE,
+                                      .brightness_mode = BRIGHTNESS_MODE_STATIC,
+                                      .hue_min = 0,
+                                      .hue_max = 360,
+                                      .color_speed = 1000U,
+                                      .brightness_min = 0U,
+                                      .brightness_max = 255U},
+#ifdef ENABLE_THE_FUZZ_ANIMATION
+    [ANIMATION_OPTION_THE_FUZZ] = {.type = ANIMATION_TYPE_FILL,
+                                   .mode = FILL_MODE_SOLID,
+                                   .color_mode = COLOR_MODE_HSV_SQUARE,
+                                   .brightness_mode = BRIGHTNESS_MODE_SEQUENCE,
+                                   .hue_min = 0,
+                                   .hue_max = 240,
+                                   .color_speed = 1000U,
+                                   .brightness_min = 0U,
+                                   .brightness_max = 255U,
+                                   .brightness_speed = 500U,
+                                   .brightness_sequence = 0xAA00U},
+#endif
+#ifdef ENABLE_FIRE_ANIMATION
+    [ANIMATION_OPTION_FIRE] = {.type = ANIMATION_TYPE_FIRE},
+#endif
+#ifdef ENABLE_EXPANDING_PULSE_ANIMATION
+    [ANIMATION_OPTION_EXPANDING_PULSE] = {.type = ANIMATION_TYPE_SCAN,
+                                          .flags = ANIMATION_FLAG_PERSONAL_HUE,
+                                          .mode = SCAN_DIRECTION_LEFT_TO_RIGHT_MIRROR,
+                                          .color_mode = COLOR_MODE_HSV_SINE,
+                                          .period = STATUS_LEDS_SCAN_SPEED,
+                                          .sigma = 70U,
+                                          .hue_min = 0,
+                                          .hue_max = 15,
+                                          .color_speed = 3000U,
+                                          .scan_end = SCAN_END_NEVER,
+                                          .modulation = ANIMATION_MOD_SPEED},
+#endif
+#ifdef ENABLE_IMPLODING_PULSE_ANIMATION
+    [ANIMATION_OPTION_IMPLODING_PULSE] = {.type = ANIMATION_TYPE_SCAN,
+                                          .flags = ANIMATION_FLAG_PERSONAL_HUE,
+                                          .mode = SCAN_DIRECTION_RIGHT_TO_LEFT_MIRROR,
+                                          .color_mode = COLOR_MODE_HSV_SINE,
+                                          .period = STATUS_LEDS_SCAN_SPEED,
+                                          .sigma = 70U,
+                                          .hue_min = 0,
+                                          .hue_max = 15,
+                                          .color_speed = 3000U,
+                                          .scan_end = SCAN_END_NEVER,
+                                          .modulation = ANIMATION_MOD_SPEED},
+#endif
+    [ANIMATION_OPTION_120_SCROLL] = {.type = ANIMATION_TYPE_FILL,
+                                     .flags =
+                                         ANIMATION_FLAG_PERSONAL_HUE | ANIMATION_FLAG_FOLLOW_ROLL,
+                                     .mode = FILL_MODE_HSV_GRADIENT,
+                                     .color_mode = COLOR_MODE_HSV_INCREASE,
+                                     .brightness_mode = BRIGHTNESS_MODE_STATIC,
+                                     .hue_min = 0,
+                                     .hue_max = 120,
+                                     .color_speed = 2000U,
+                                     .brightness_min = 0U,
+                                     .brightness_max = 255U},
+    [ANIMATION_OPTION_COMPLEMENTARY_WAVE] = {.type = ANIMATION_TYPE_FILL,
+                                             .flags = ANIMATION_FLAG_PERSONAL_HUE |
+                                                      ANIMATION_FLAG_HUE_WRAP,
+                                             .mode = FILL_MODE_HSV_GRADIENT_MIRROR,
+                                             .color_mode = COLOR_MODE_HSV_SQUARE,
+                                             .brightness_mode = BRIGHTNESS_MODE_STATIC,
+                                             .hue_min = 0,
+                                             .hue_max = 180,
+                                             .color_speed = 2000U,
+                                             .brightness_min = 255U,
+                                             .brightness_max = 255U},
+    [ANIMATION_OPTION_FLOATWHEEL_CLASSIC] = {.type = ANIMATION_TYPE_SCAN,
+                                             .flags = ANIMATION_FLAG_PERSONAL_RGB,
+                                             .mode = SCAN_DIRECTION_LEFT_TO_RIGHT_FILL,
+                                             .color_mode = COLOR_MODE_RGB,
+                                             .period = 5500U,
+                                             .sigma = 70U,
+                                             .scan_end = SCAN_END_MAX_MU},
+    [ANIMATION_OPTION_PERSONAL_SCAN] = {.type = ANIMATION_TYPE_SCAN,
+                                        .flags = ANIMATION_FLAG_PERSONAL_RGB,
+                                        .mode = SCAN_DIRECTION_SINE,
+                                        .color_mode = COLOR_MODE_RGB,
+                                        .period = STATUS_LEDS_SCAN_SPEED,
+                                        .sigma = 70U,
+                                        .scan_end = SCAN_END_NEVER,
+                                        .modulation = ANIMATION_MOD_SPEED},
+};
+
+/**
+ * @brief Starts the animation described by a parameter block
+ *
+ * Personal color and board roll are resolved here, everything else is
+ * passed through to the setup function for the animation type.
+ *
+ * @param params The animation to start
+ * @return The ID of the started animation
+ */
+static uint16_t status_leds_start_animation_params(const animation_params_t *params)
 {
     uint16_t animation_id = 0U;
     uint8_t first_led = 0U;
-    uint8_t last_led = STATUS_LEDS_COUNT - 1U;
+    uint8_t last_led = status_leds_count - 1U;
+    float32_t hue_min = (float32_t)params->hue_min;
+    float32_t hue_max = (float32_t)params->hue_max;
+    const status_leds_color_t *rgb = &params->rgb;
 
 #ifdef ENABLE_IMU_EVENTS
-        if (vesc_serial_get_imu_roll() < 0.0f)
-        {
-            first_led = STATUS_LEDS_COUNT - 1U;
-            last_led = 0U;
-        }
-#endif
-    switch (option)
+    if (((params->flags & ANIMATION_FLAG_FOLLOW_ROLL) != 0U) &&
+        (vesc_serial_get_telemetry()->imu_roll < 0))
     {
-    case ANIMATION_OPTION_RAINBOW_SCAN:
-        animation_id =
-            scan_animation_setup(status_leds_buffer, SCAN_DIRECTION_SINE, COLOR_MODE_HSV_DECREASE,
-                                 STATUS_LEDS_SCAN_SPEED, // scan speed in milliseconds
-                                 SIGMA_DEFAULT,
-                                 0.0f,    // hue min
-                                 360.0f,  // hue max
-                                 3000.0f, // color change speed
-                                 SCAN_START_DEFAULT, SCAN_END_NEVER, 0.0f,
-                                 NULL // RGB color (ignored)
-            );
-        break;
-#ifdef ENABLE_KNIGHT_RIDER_ANIMATION
-    case ANIMATION_OPTION_KNIGHT_RIDER:
-        animation_id = scan_animation_setup(status_leds_buffer, SCAN_DIRECTION_SINE, COLOR_MODE_RGB,
-                                            STATUS_LEDS_SCAN_SPEED, // scan speed in milliseconds
-                                            SIGMA_DEFAULT,
-                                            0.0f, // (not-used)
-                                            0.0f, // (not-used)
-                                            0.0f, // (not-used)
-                                            SCAN_START_DEFAULT, SCAN_END_NEVER, 0.0f,
-                                            &colors.red // RGB color
-        );
-        break;
-#endif
-    case ANIMATION_OPTION_RAINBOW_MIRROR:
-        animation_id = fill_animation_setup(status_leds_buffer, COLOR_MODE_HSV_INCREASE,
-                                            BRIGHTNESS_MODE_STATIC, FILL_MODE_HSV_GRADIENT_MIRROR,
-                                            0U, STATUS_LEDS_COUNT - 1U,
-                                            0.0f,    // hue min
-                                            360.0f,  // hue max
-                                            1500.0f, // color change speed
-                                            0.0f,    // brightness min
-                                            1.0f,    // brightness max
-                                            0.0f,    // brightness change speed
-                                            0U,
-                                            NULL // RGB color (ignored)
-        );
-        break;
-#ifdef ENABLE_EXPANDING_PULSE_ANIMATION
-    case ANIMATION_OPTION_EXPANDING_PULSE:
-        animation_id = scan_animation_setup(
-            status_leds_buffer, SCAN_DIRECTION_LEFT_TO_RIGHT_MIRROR, COLOR_MODE_HSV_SINE,
-            STATUS_LEDS_SCAN_SPEED, // scan speed in milliseconds
-            SIGMA_DEFAULT,
-            status_leds_settings->personal_color,                              // hue min
-            CLAMP(status_leds_settings->personal_color + 15.0f, 0.0f, 360.0f), // hue max
-            3000.0f, SCAN_START_DEFAULT, SCAN_END_NEVER, 0.0f, NULL);
-        break;
-#endif
-#ifdef ENABLE_THE_FUZZ_ANIMATION
-    case ANIMATION_OPTION_THE_FUZZ:
-        animation_id = fill_animation_setup(status_leds_buffer, COLOR_MODE_HSV_SQUARE,
-                                            BRIGHTNESS_MODE_SEQUENCE, FILL_MODE_SOLID, 0U,
-                                            STATUS_LEDS_COUNT - 1U,
-                                            0.0f,    // hue min
-                                            240.0f,  // hue max
-                                            1000.0f, // color change speed
-                                            0.0f,    // brightness min
-                                            1.0f,    // brightness max
-                                            500.0f,  // brightness speed
-                                            0xAA00,  // bright sequence
-                                            NULL     // RGB color (ignored)
-        );
-        break;
+        first_led = status_leds_count - 1U;
+        last_led = 0U;
+    }
 #endif
-    case ANIMATION_OPTION_120_SCROLL:
-        animation_id = fill_animation_setup(
-            status_leds_buffer, COLOR_MODE_HSV_INCREASE, BRIGHTNESS_MODE_STATIC,
-            FILL_MODE_HSV_GRADIENT, first_led, last_led,
-            status_leds_settings->personal_color,                               // hue min
-            CLAMP(status_leds_settings->personal_color + 120.0f, 0.0f, 360.0f), // hue max
-            2000.0f, // color change speed
-            0.0f,    // brightness min
-            1.0f,    // brightness max
-            0.0f,    // brightness change speed
-            0U,
-            NULL // RGB color (ignored)
-        );
+
+    if ((params->flags & ANIMATION_FLAG_PERSONAL_HUE) != 0U)
+    {
+        hue_min += status_leds_settings->personal_color;
+        hue_max += status_leds_settings->personal_color;
+    }
+
+    if ((params->flags & ANIMATION_FLAG_HUE_WRAP) != 0U)
+    {
+        // Wrap both ends onto the wheel and keep them in order
+        float32_t hue_a = tiny_fmodf(hue_min + 360.0f, 360.0f);
+        float32_t hue_b = tiny_fmodf(hue_max + 360.0f, 360.0f);
+        hue_min = MIN(hue_a, hue_b);
+        hue_max = MAX(hue_a, hue_b);
+    }
+    else
+    {
+        hue_min = CLAMP(hue_min, 0.0f, 360.0f);
+        hue_max = CLAMP(hue_max, 0.0f, 360.0f);
+    }
+
+    if ((params->flags & ANIMATION_FLAG_PERSONAL_RGB) != 0U)
+    {
+        rgb = &custom_color;
+    }
+
+    switch (params->type)
+    {
+    case ANIMATION_TYPE_FADE:
+        // Fade out the lights and then disable
+        animation_id = fade_animation_setup(status_leds_buffer, params->period, NULL);
         break;
-#ifdef ENABLE_IMPLODING_PULSE_ANIMATION
-    case ANIMATION_OPTION_IMPLODING_PULSE:
+    case ANIMATION_TYPE_SCAN:
         animation_id = scan_animation_setup(
-            status_leds_buffer, SCAN_DIRECTION_RIGHT_TO_LEFT_MIRROR, COLOR_MODE_HSV_SINE,
-            STATUS_LEDS_SCAN_SPEED, // scan speed in milliseconds
-            SIGMA_DEFAULT,
-            status_leds_settings->personal_color,                              // hue min
-            CLAMP(status_leds_settings->personal_color + 15.0f, 0.0f, 360.0f), // hue max
-            3000.0f, SCAN_START_DEFAULT, SCAN_END_NEVER, 0.0f, NULL);
-        break;
-#endif
-    case ANIMATION_OPTION_RAINBOW_BAR:
-        animation_id = fill_animation_setup(status_leds_buffer, COLOR_MODE_HSV_INCREASE,
-                                            BRIGHTNESS_MODE_STATIC, FILL_MODE_HSV_GRADIENT, first_led, last_led,
-                                            0.0f,    // hue min
-                                            360.0f,  // hue max
-                                            1000.0f, // color change speed
-                                            0.0f,    // brightness min
-                                            1.0f,    // brightness max
-                                            0.0f,    // brightness change speed
-                                            0U,
-                                            NULL // RGB color (ignored)
-        );
+            status_leds_buffer, (scan_direction_t)params->mode,
+            (color_mode_t)params->color_mode, (float32_t)params->period,
+            (float32_t)params->sigma / 100.0f, hue_min, hue_max, (float32_t)params->color_speed,
+            SCAN_START_DEFAULT, (scan_end_t)params->scan_end, 0.0f, rgb);
         break;
-    case ANIMATION_OPTION_COMPLEMENTARY_WAVE:
+    case ANIMATION_TYPE_FILL:
         animation_id = fill_animation_setup(
-            status_leds_buffer, COLOR_MODE_HSV_SQUARE, BRIGHTNESS_MODE_STATIC,
-            FILL_MODE_HSV_GRADIENT_MIRROR, 0U, STATUS_LEDS_COUNT - 1U,
-            MIN(status_leds_settings->personal_color,
-                tiny_fmodf(status_leds_settings->personal_color + 180.0f, 360.0f)),
-            MAX(status_leds_settings->personal_color,
-                tiny_fmodf(status_leds_settings->personal_color + 180.0f, 360.0f)),
-            2000.0f, // color change speed
-            1.0f,    // brightness min
-            1.0f,    // brightness max
-            0.0f,    // brightness change speed
-            0U,
-            NULL // RGB color
-        );
-        break;
-    case ANIMATION_OPTION_PERSONAL_SCAN:
-        animation_id = scan_animation_setup(status_leds_buffer, SCAN_DIRECTION_SINE, COLOR_MODE_RGB,
-                                            STATUS_LEDS_SCAN_SPEED, // scan speed in milliseconds
-                                            SIGMA_DEFAULT,
-                                            0.0f, // (not-used)
-                                            0.0f, // (not-used)
-                                            0.0f, // (not-used)
-                                            SCAN_START_DEFAULT, SCAN_END_NEVER, 0.0f,
-                                            &custom_color // RGB color
-        );
+            status_leds_buffer, (color_mode_t)params->color_mode,
+            (brightness_mode_t)params->brightness_mode, (fill_mode_t)params->mode, first_led,
+            last_led, hue_min, hue_max, (float32_t)params->color_speed,
+            (float32_t)params->brightness_min / 255.0f, (float32_t)params->brightness_max / 255.0f,
+            (float32_t)params->brightness_speed, params->brightness_sequence, rgb);
         break;
 #ifdef ENABLE_FIRE_ANIMATION
-    case ANIMATION_OPTION_FIRE:
+    case ANIMATION_TYPE_FIRE:
         animation_id = fire_animation_setup(status_leds_buffer);
         break;
 #endif
-    case ANIMATION_OPTION_FLOATWHEEL_CLASSIC:
-        animation_id = scan_animation_setup(status_leds_buffer, SCAN_DIRECTION_LEFT_TO_RIGHT_FILL,
-                                            COLOR_MODE_RGB,
-                                            5500.0f, // scan speed in milliseconds
-                                            SIGMA_DEFAULT,
-                                            0.0f, // (not-used)
-                                            0.0f, // (not-used)
-                                            0.0f, // (not-used)
-                                            SCAN_START_DEFAULT, SCAN_END_MAX_MU, 0.0f,
-                                            &custom_color // RGB color
-        );
-        break;
-    case ANIMATION_OPTION_NONE:
-        // Fade out the lights and then disable
-        animation_id =
-            fade_animation_setup(status_leds_buffer, STATUS_LEDS_FADE_TO_BLACK_TIMEOUT, NULL);
-        break;
-    case ANIMATION_OPTION_COUNT:
-        // Fall through intentional
     default:
         fault(EMERGENCY_FAULT_INVALID_STATE);
         break;
     }
 
+    // Bind the animation to the telemetry, the level is fed by
+    // status_leds_update_modulation()
+    status_leds_modulation = params->modulation;
+    animation_modulate(params->modulation);
+
     return animation_id;
 }
 
+uint16_t status_leds_start_animation_option(animation_option_t option)
+{
+    uint16_t animation_id = 0U;
+
+    if (option >= ANIMATION_OPTION_COUNT)
+    {
+        fault(EMERGENCY_FAULT_INVALID_STATE);
+    }
+#ifdef ENABLE_CUSTOM_ANIMATIONS
+    else if (option >= ANIMATION_OPTION_CUSTOM_1)
+    {
+        // Custom animations are read from the settings in EEPROM
+        animation_id = status_leds_start_animation_params(
+            &status_leds_settings->custom_animations[option - ANIMATION_OPTION_CUSTOM_1]);
+    }
+#endif
+    else
+    {
+        animation_id = status_leds_start_animation_params(&builtin_animations[option]);
+    }
+
+    return animation_id;
+}
+
+/**
+ * @brief Shows or hides an overlay layer
+ *
+ * @param layer The layer to change
+ * @param visible True to compose the layer, false to hide it
+ */
+static void status_leds_show_layer(status_leds_layer_id_t layer, bool_t visible)
+{
+    if (status_leds_layers[layer].visible != visible)
+    {
+        status_leds_layers[layer].visible = visible;
+        status_leds_refresh();
+    }
+    // No else needed, nothing changed
+}
+
+/**
+ * @brief Hides all overlay layers, leaving only the animation buffer
+ *
+ * A running crossfade is left alone. The alert layer is driven by the
+ * animation engine, so its animation is stopped along with it.
+ */
+static void status_leds_hide_overlays(void)
+{
+    if (status_leds_layers[STATUS_LEDS_LAYER_ALERT].visible &&
+        (get_animation_id() == battery_animation_id))
+    {
+        stop_animation();
+    }
+
+    for (uint8_t i = 0; i < STATUS_LEDS_LAYER_CROSSFADE; i++)
+    {
+        status_leds_show_layer((status_leds_layer_id_t)i, false);
+    }
+}
+
+/**
+ * @brief Combines one channel of a layer pixel with the pixel below it
+ */
+static uint8_t status_leds_blend(uint8_t below, uint8_t above, status_leds_blend_t blend,
+                                 uint8_t alpha)
+{
+    uint16_t result = above;
+
+    switch (blend)
+    {
+    case STATUS_LEDS_BLEND_ALPHA:
+    {
+        // Map alpha 255 to 256 so an opaque layer shifts out exactly
+        uint16_t weight = (uint16_t)alpha + (alpha >> 7);
+        result = (uint16_t)(((below * (256U - weight)) + (above * weight)) >> 8);
+        break;
+    }
+    case STATUS_LEDS_BLEND_ADD:
+        result = MIN((uint16_t)below + above, 255U);
+        break;
+    case STATUS_LEDS_BLEND_REPLACE:
+        // Fall through to default
+    default:
+        break;
+    }
+
+    return (uint8_t)result;
+}
+
+/**
+ * @brief Composes the animation buffer and visible overlays into the frame
+ */
+static void status_leds_compose(void)
+{
+    status_leds_layer_t *crossfade = &status_leds_layers[STATUS_LEDS_LAYER_CROSSFADE];
+
+    for (uint8_t i = 0; i < status_leds_count; i++)
+    {
+        status_leds_frame[i] = status_leds_buffer[i];
+    }
+
+    // The crossfade is driven by the animation timer, drop it once it is done
+    if (crossfade->visible)
+    {
+        crossfade->alpha = animation_crossfade_alpha();
+        crossfade->visible = (crossfade->alpha > 0U);
+    }
+
+    for (uint8_t l = 0; l < STATUS_LEDS_LAYER_COUNT; l++)
+    {
+        const status_leds_layer_t *layer = &status_leds_layers[l];
+        uint8_t last_led = MIN(layer->last_led, status_leds_count - 1U);
+
+        if (layer->visible)
+        {
+            for (uint8_t i = layer->first_led; i <= last_led; i++)
+            {
+                status_leds_frame[i].r = status_leds_blend(
+                    status_leds_frame[i].r, layer->pixels[i].r, layer->blend, layer->alpha);
+                status_leds_frame[i].g = status_leds_blend(
+                    status_leds_frame[i].g, layer->pixels[i].g, layer->blend, layer->alpha);
+                status_leds_frame[i].b = status_leds_blend(
+                    status_leds_frame[i].b, layer->pixels[i].b, layer->blend, layer->alpha);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Merges the visible overlays into the animation buffer
+ *
+ * Used before an animation that should start from what the strip is
+ * currently showing, such as fading out the lights.
+ */
+static void status_leds_flatten(void)
+{
+    status_leds_compose();
+    for (uint8_t i = 0; i < status_leds_count; i++)
+    {
+        status_leds_buffer[i] = status_leds_frame[i];
+    }
+    status_leds_hide_overlays();
+
+    if (status_leds_layers[STATUS_LEDS_LAYER_CROSSFADE].visible)
+    {
+        animation_crossfade_start(0U);
+        status_leds_show_layer(STATUS_LEDS_LAYER_CROSSFADE, false);
+    }
+}
+
+/**
+ * @brief Starts fading out what the strip currently shows
+ *
+ * The current frame is held in the crossfade layer and fades out over
+ * whatever is drawn next. Only the held frame and the incoming display are
+ * blended, so a crossfade costs one layer in the compositor rather than a
+ * second running animation.
+ */
+static void status_leds_crossfade(void)
+{
+#if STATUS_LEDS_CROSSFADE_FRAMES > 0
+    status_leds_layer_t *crossfade = &status_leds_layers[STATUS_LEDS_LAYER_CROSSFADE];
+
+    status_leds_compose();
+    for (uint8_t i = 0; i < status_leds_count; i++)
+    {
+        crossfade->pixels[i] = status_leds_frame[i];
+    }
+    crossfade->alpha = 255U;
+    crossfade->visible = true;
+    animation_crossfade_start(STATUS_LEDS_CROSSFADE_FRAMES);
+#endif
+}
+
+/**
+ * @brief Converts a battery level to the gauge segment it falls in
+ *
+ * @param battery_level The battery level in 0.1% units
+ * @return The segment, in 1 / BATTERY_GAUGE_SEGMENTS_PER_LED of an LED
+ */
+static int16_t battery_gauge_segment(int16_t battery_level)
+{
+    return (int16_t)(((int32_t)battery_level * BATTERY_GAUGE_SEGMENTS_PER_LED * status_leds_count) /
+                     BATTERY_GAUGE_FULL_LEVEL);
+}
+
+/**
+ * @brief Updates the battery gauge in the battery layer
+ *
+ * The gauge only moves to a new segment once the battery level is a little
+ * past the segment edge, so a reading that wobbles around an edge does not
+ * make the bar flicker. It is only redrawn when the segment or the color
+ * changes.
+ *
+ * @param battery_level The current battery level in 0.1% units
+ * @param color The color of the bar
+ */
+static void battery_gauge_update(int16_t battery_level, const status_leds_color_t *color)
+{
+    int16_t segment = battery_gauge.segment;
+
+    if (segment == BATTERY_GAUGE_NOT_DRAWN)
+    {
+        segment = battery_gauge_segment(battery_level);
+    }
+    else if (battery_gauge_segment(battery_level - BATTERY_GAUGE_HYSTERESIS) > segment)
+    {
+        segment = battery_gauge_segment(battery_level - BATTERY_GAUGE_HYSTERESIS);
+    }
+    else if (battery_gauge_segment(battery_level + BATTERY_GAUGE_HYSTERESIS) < segment)
+    {
+        segment = battery_gauge_segment(battery_level + BATTERY_GAUGE_HYSTERESIS);
+    }
+    // No else needed, the level is still within the drawn segment
+
+    if ((segment != battery_gauge.segment) || (color != battery_gauge.color))
+    {
+        battery_gauge.segment = segment;
+        battery_gauge.color = color;
+
+        // The bar ends one LED before the level, so 0% is dark and 100% lights
+        // the whole strip
+        bar_fill(status_leds_layers[STATUS_LEDS_LAYER_BATTERY].pixels,
+                 ((int32_t)segment * (256 / BATTERY_GAUGE_SEGMENTS_PER_LED)) - 256, color);
+        status_leds_refresh();
+    }
+    // No else needed, the gauge already shows this
+}
+
 /**
  * @brief Displays the current battery level on the status LEDs
  *
- * This function uses the first 10 status LEDs to display the current battery
- * level. The LEDs are divided into 10 equal parts, with each part representing
- * 10% of the battery capacity.
+ * This function uses the whole strip to display the current battery level as
+ * a bar, so each LED represents an equal share of the battery capacity
+ * whatever the number of LEDs.
  *
- * @param battery_level The current battery level, specified as a float
- *                       between 100.0 and 0.0
+ * @param battery_level The current battery level in 0.1% units, between 0
+ *                      and 1000
  */
-void display_battery(float32_t battery_level)
+void display_battery(int16_t battery_level)
 {
+    const status_leds_color_t *color = &colors.white;
+    status_leds_layer_t *alert = &status_leds_layers[STATUS_LEDS_LAYER_ALERT];
+
+    if (battery_level <= LOW_BATTERY_THRESHOLD)
+    {
+        color = &colors.orange;
+    }
+
+    battery_gauge_update(battery_level, color);
+    status_leds_show_layer(STATUS_LEDS_LAYER_BATTERY, true);
+
     if (battery_level <= CRITICAL_BATTERY_THRESHOLD)
     {
-        // Check if we need to start a new animation
-        if (get_animation_id() != battery_animation_id)
+        // Start the red flash on the alert layer unless it is already running
+        if (!alert->visible)
         {
-            // Stop any existing animation
-            stop_animation();
-
-            // Start a red flash animation
-            battery_animation_id = fill_animation_setup(status_leds_buffer, COLOR_MODE_RGB,
+            battery_animation_id = fill_animation_setup(alert->pixels, COLOR_MODE_RGB,
                                                         BRIGHTNESS_MODE_SINE, FILL_MODE_SOLID,
                                                         0U,     // fisrt LED to animate
                                                         0U,     // last LED to animate
@@ -330,85 +726,73 @@ void display_battery(float32_t battery_level)
                                                         0U,
                                                         &colors.red // RGB color
             );
+            status_leds_show_layer(STATUS_LEDS_LAYER_ALERT, true);
         }
     }
-    else
+    else if (alert->visible)
     {
-        const status_leds_color_t *color = &colors.white;
-        stop_animation();
-
-        if (battery_level <= LOW_BATTERY_THRESHOLD)
+        if (get_animation_id() == battery_animation_id)
         {
-            color = &colors.orange;
+            stop_animation();
         }
-
-        scan_animation_setup(status_leds_buffer, SCAN_DIRECTION_LEFT_TO_RIGHT_FILL, COLOR_MODE_RGB,
-                             500.0f, // scan speed in milliseconds
-                             SIGMA_DEFAULT,
-                             0.0f, // (not-used)
-                             0.0f, // (not-used)
-                             0.0f, // (not-used)
-                             SCAN_START_MU, SCAN_END_SINGLE_TICK,
-                             (float32_t)((battery_level / 10.0f) - 1.0f),
-                             color // RGB color
-        );
+        status_leds_show_layer(STATUS_LEDS_LAYER_ALERT, false);
     }
+    // No else needed, no alert to clear
 }
 
 /**
  * @brief Displays the footpad state on the status LEDs.
  *
- * This function updates the status LEDs to reflect the current state of the
+ * This function updates the footpad layer to reflect the current state of the
  * footpads. If the left footpad is pressed, the left half of the LEDs will
- * be illuminated in light blue. If the right footpad is pressed, the right
- * half will be illuminated. If both footpads are pressed, all LEDs will
- * be illuminated. Any current animations are stopped before updating the
- * display.
+ * be illuminated in the personal color. If the right footpad is pressed, the
+ * right half will be illuminated. If both footpads are pressed, all LEDs will
+ * be illuminated. The layer is hidden when no footpad is pressed, and the
+ * animation below it keeps running.
  *
  * @param footpad The current state of the footpads, specified as a bitwise OR
  *                of #LEFT_FOOTPAD and #RIGHT_FOOTPAD.
  */
 void display_footpad(footpads_state_t footpad)
 {
-    // Stop any current animation
-    stop_animation();
+    status_leds_color_t *pixels = status_leds_layers[STATUS_LEDS_LAYER_FOOTPAD].pixels;
+    const status_leds_strip_t *strips = status_leds_settings->status_leds_strips;
+    uint8_t first_led = 0U;
 
-    // Clear the current display
-    if (LCM_SUCCESS != status_leds_set_color(&colors.black, 0U, STATUS_LEDS_COUNT - 1U))
+    if (footpad == NONE_FOOTPAD)
     {
-        fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
+        status_leds_show_layer(STATUS_LEDS_LAYER_FOOTPAD, false);
+        return;
     }
 
-    switch (footpad)
+    if ((uint8_t)footpad != footpad_layer_state)
     {
-    case LEFT_FOOTPAD:
-        if (LCM_SUCCESS != status_leds_set_color(&custom_color, 0U, (STATUS_LEDS_COUNT / 2U) - 1U))
-        {
-            fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
-        }
-        break;
-    case RIGHT_FOOTPAD:
-        if (LCM_SUCCESS !=
-            status_leds_set_color(&custom_color, (STATUS_LEDS_COUNT / 2), STATUS_LEDS_COUNT - 1U))
-        {
-            fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
-        }
-        break;
-    case LEFT_FOOTPAD | RIGHT_FOOTPAD:
-        if (LCM_SUCCESS != status_leds_set_color(&custom_color, 0U, STATUS_LEDS_COUNT - 1U))
+        footpad_layer_state = (uint8_t)footpad;
+
+        // Each strip shows the left footpad on its first half and the right
+        // footpad on its second half
+        for (uint8_t s = 0; s < STATUS_LEDS_MAX_STRIPS; s++)
         {
-            fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
-        }
-        break;
-    default:
-        // Do nothing
-        break;
-    }
+            for (uint8_t i = 0; i < strips[s].count; i++)
+            {
+                bool_t lit = false;
 
-    if (LCM_SUCCESS != status_leds_refresh())
-    {
-        fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
+                if (i < (strips[s].count / 2U))
+                {
+                    lit = (footpad & LEFT_FOOTPAD) != 0U;
+                }
+                else
+                {
+                    lit = (footpad & RIGHT_FOOTPAD) != 0U;
+                }
+
+                pixels[first_led + i] = lit ? custom_color : colors.black;
+            }
+            first_led += strips[s].count;
+        }
+        status_leds_refresh();
     }
+    status_leds_show_layer(STATUS_LEDS_LAYER_FOOTPAD, true);
 }
 
 void status_leds_disable_beeper_callback(void)
@@ -446,7 +830,8 @@ void status_leds_color_callback(void)
     stop_animation();
     hsl_to_rgb(status_leds_settings->personal_color, SATURATION_DEFAULT, LIGHTNESS_DEFAULT,
                &custom_color);
-    status_leds_set_color(&custom_color, 0U, STATUS_LEDS_COUNT - 1U);
+    footpad_layer_state = STATUS_LEDS_FOOTPAD_NOT_DRAWN;
+    status_leds_set_color(&custom_color, 0U, status_leds_count - 1U);
     status_leds_refresh();
 }
 
@@ -500,7 +885,7 @@ void status_leds_handle_fault(event_type_t event)
 
         // Start the red/yellow fault animation
         fill_animation_setup(status_leds_buffer, COLOR_MODE_RGB, BRIGHTNESS_MODE_SEQUENCE,
-                            FILL_MODE_SOLID, 0U, STATUS_LEDS_COUNT - 1U,
+                            FILL_MODE_SOLID, 0U, status_leds_count - 1U,
                             0.0f,   // hue min
                             0.0f,   // hue max
                             0.0f,   // color change speed
@@ -521,16 +906,9 @@ void status_leds_handle_fault(event_type_t event)
  */
 void status_leds_handle_idle_active(event_type_t event)
 {
-    // Display the battery level unless the footpads are pressed
-    footpads_state_t footpads = footpads_get_state();
-    if (footpads == NONE_FOOTPAD)
-    {
-        display_battery(vesc_serial_get_battery_level());
-    }
-    else
-    {
-        display_footpad(footpads);
-    }
+    // Display the battery level, covered by the footpads while pressed
+    display_footpad(footpads_get_state());
+    display_battery(vesc_serial_get_telemetry()->battery_level);
 }
 
 /**
@@ -605,7 +983,7 @@ void status_leds_handle_idle_config(event_type_t event)
     case EVENT_COMMAND_CONTEXT_CHANGED:
         // Stop any current animations and display magenta
         stop_animation();
-        if (LCM_SUCCESS != status_leds_set_color(&colors.magenta, 0U, STATUS_LEDS_COUNT - 1U))
+        if (LCM_SUCCESS != status_leds_set_color(&colors.magenta, 0U, status_leds_count - 1U))
         {
             // Failed to set color, return early
             return;
@@ -624,7 +1002,7 @@ void status_leds_handle_riding_danger(event_type_t event)
     {
     case EVENT_BOARD_MODE_CHANGED:
         fill_animation_setup(status_leds_buffer, COLOR_MODE_RGB, BRIGHTNESS_MODE_SINE,
-                             FILL_MODE_SOLID, 0U, STATUS_LEDS_COUNT - 1U,
+                             FILL_MODE_SOLID, 0U, status_leds_count - 1U,
                              0.0f,   // hue min
                              0.0f,   // hue max
                              0.0f,   // color change speed
@@ -657,7 +1035,7 @@ void status_leds_handle_riding_warning(event_type_t event)
     {
     case EVENT_BOARD_MODE_CHANGED:
         fill_animation_setup(status_leds_buffer, COLOR_MODE_HSV_SQUARE, BRIGHTNESS_MODE_SINE,
-                             FILL_MODE_HSV_GRADIENT_MIRROR, 0U, STATUS_LEDS_COUNT - 1U,
+                             FILL_MODE_HSV_GRADIENT_MIRROR, 0U, status_leds_count - 1U,
                              10.0f,  // hue min
                              40.0f,  // hue max
                              350.0f, // color change speed
@@ -682,7 +1060,7 @@ void status_leds_handle_riding_warning(event_type_t event)
  */
 void status_leds_handle_riding_slow(event_type_t event)
 {
-    float32_t battery_level = vesc_serial_get_battery_level();
+    int16_t battery_level = vesc_serial_get_telemetry()->battery_level;
     display_battery(battery_level);
 }
 
@@ -698,13 +1076,19 @@ void status_leds_handle_riding_slow(event_type_t event)
  */
 void status_leds_handle_riding_normal(event_type_t event)
 {
-    float32_t battery_level = vesc_serial_get_battery_level();
+    int16_t battery_level = vesc_serial_get_telemetry()->battery_level;
 
     if (battery_level <= LOW_BATTERY_THRESHOLD)
     {
         display_battery(battery_level);
+        return;
     }
-    else if (get_animation_id() != ride_animation_id)
+
+    // The battery is fine again, uncover the ride animation
+    status_leds_show_layer(STATUS_LEDS_LAYER_BATTERY, false);
+    status_leds_show_layer(STATUS_LEDS_LAYER_ALERT, false);
+
+    if (get_animation_id() != ride_animation_id)
     {
         // Check if the always on ride animation is set
         if (status_leds_settings->ride_animation != ANIMATION_OPTION_NONE)
@@ -733,6 +1117,14 @@ void status_leds_handle_riding_normal(event_type_t event)
  */
 void update_display(event_type_t event)
 {
+    // Each mode starts from the bare animation buffer and shows the overlays
+    // it needs, faded in over the last frame of the previous mode
+    if (event == EVENT_BOARD_MODE_CHANGED)
+    {
+        status_leds_crossfade();
+        status_leds_hide_overlays();
+    }
+
     // Determine the current state
     switch (board_mode_get())
     {
@@ -819,7 +1211,7 @@ lcm_status_t status_leds_set_color(const status_leds_color_t *color, uint8_t beg
 {
     lcm_status_t result = LCM_SUCCESS;
 
-    if ((begin > end) || (end > (STATUS_LEDS_COUNT - 1U)) || (color == NULL))
+    if ((begin > end) || (end >= status_leds_count) || (color == NULL))
     {
         result = LCM_ERROR;
     }
@@ -838,18 +1230,172 @@ lcm_status_t status_leds_set_color(const status_leds_color_t *color, uint8_t beg
 }
 
 /**
- * @brief Refreshes the status LEDs display.
+ * @brief Returns the total number of LEDs on a set of chained strips.
  *
- * This function updates the status LEDs hardware with the current color
- * buffer, ensuring that the LEDs show the latest colors set by the system.
+ * @param strips STATUS_LEDS_MAX_STRIPS strip descriptors
+ * @return The number of LEDs, or 0 if it does not fit STATUS_LEDS_MAX_COUNT
+ * or a strip has an unknown channel order
+ */
+uint8_t status_leds_strips_count(const status_leds_strip_t *strips)
+{
+    uint16_t count = 0U;
+    bool_t valid = true;
+
+    for (uint8_t s = 0; s < STATUS_LEDS_MAX_STRIPS; s++)
+    {
+        if (strips[s].order >= STATUS_LEDS_ORDER_COUNT)
+        {
+            valid = false;
+        }
+        count += strips[s].count;
+    }
+
+    if (!valid || (count > STATUS_LEDS_MAX_COUNT))
+    {
+        count = 0U;
+    }
+
+    return (uint8_t)count;
+}
+
+/**
+ * @brief Returns the number of status LEDs, on all strips together.
  */
+uint8_t status_leds_get_count(void)
+{
+    return status_leds_count;
+}
 
+/**
+ * @brief Refreshes the status LEDs display.
+ *
+ * This function marks the color buffer as ready to be shown. The hardware is
+ * updated by status_leds_flush() at the end of the event loop pass, so any
+ * number of refreshes in one pass cost a single transmit.
+ */
 lcm_status_t status_leds_refresh(void)
 {
-    status_leds_hw_refresh();
+    status_leds_refresh_pending = true;
     return LCM_SUCCESS;
 }
 
+/**
+ * @brief Forces the next refresh to be sent even if the frame is unchanged.
+ *
+ * Used when something other than the color buffer changes what the strip
+ * shows, such as the global brightness.
+ */
+static void status_leds_invalidate(void)
+{
+    status_leds_frame_valid = false;
+    status_leds_refresh_pending = true;
+}
+
+/**
+ * @brief Sends a pending refresh to the status LEDs hardware.
+ *
+ * Called once per event loop pass. The layers are composed into the frame and
+ * it is only transmitted if a refresh was requested and its checksum differs
+ * from the frame last sent, so static displays and redundant redraws do not
+ * touch the strip.
+ */
+void status_leds_flush(void)
+{
+    // While the previous frame is still going out the refresh stays pending,
+    // and the frame is composed from the latest state once the link is free
+    if (status_leds_refresh_pending && !status_leds_hw_busy())
+    {
+        uint16_t crc = 0U;
+
+        status_leds_compose();
+        crc = crc16_ccitt((const uint8_t *)status_leds_frame,
+                          (uint16_t)(status_leds_count * sizeof(status_leds_color_t)));
+
+        status_leds_refresh_pending = false;
+        if (!status_leds_frame_valid || (crc != status_leds_frame_crc))
+        {
+            status_leds_frame_crc = crc;
+            status_leds_frame_valid = true;
+            status_leds_hw_refresh(status_leds_frame);
+        }
+        // No else needed, the strip already shows this frame
+    }
+}
+
+#ifdef ENABLE_STATUS_LEDS_BENCHMARK
+#define STATUS_LEDS_BENCHMARK_FRAMES 8U
+
+/**
+ * @brief Average time taken by a frame in microseconds, indexed by the LED
+ * count - 1
+ *
+ * Each frame is a scan animation step, composing the layers and sending the
+ * frame to the strip. Read it with the debugger after boot.
+ */
+volatile uint32_t status_leds_benchmark_us[STATUS_LEDS_MAX_COUNT] = {0U};
+
+/**
+ * @brief Longest strip that fits in a frame at 40 fps, extrapolated from the
+ * cost of the first and the last LED count measured.
+ */
+volatile uint16_t status_leds_benchmark_max_count = 0U;
+
+/**
+ * @brief Measures the cost of a frame for every strip length up to
+ * STATUS_LEDS_MAX_COUNT.
+ *
+ * Runs once at boot, before the event loop starts. The configured strip
+ * length is restored afterwards.
+ */
+static void status_leds_benchmark(void)
+{
+    const uint8_t configured_count = status_leds_count;
+    const uint32_t budget = 1000000U / 40U;
+    status_leds_strip_t strips[STATUS_LEDS_MAX_STRIPS] = {0};
+    uint32_t per_led = 0U;
+
+    // Time a single strip with the channel order of the first one
+    strips[0].order = status_leds_settings->status_leds_strips[0].order;
+
+    for (uint8_t count = 1U; count <= STATUS_LEDS_MAX_COUNT; count++)
+    {
+        uint32_t start = 0U;
+
+        status_leds_count = count;
+        strips[0].count = count;
+        status_leds_hw_set_strips(strips);
+        status_leds_start_animation_option(ANIMATION_OPTION_RAINBOW_SCAN);
+
+        start = status_leds_hw_micros();
+        for (uint8_t frame = 0U; frame < STATUS_LEDS_BENCHMARK_FRAMES; frame++)
+        {
+            animation_step(frame);
+            status_leds_invalidate();
+            status_leds_flush();
+            while (status_leds_hw_busy())
+                ;
+        }
+        status_leds_benchmark_us[count - 1U] =
+            (status_leds_hw_micros() - start) / STATUS_LEDS_BENCHMARK_FRAMES;
+    }
+
+    // The cost grows linearly with the strip length
+    per_led = (status_leds_benchmark_us[STATUS_LEDS_MAX_COUNT - 1U] -
+               status_leds_benchmark_us[0]) /
+              MAX(STATUS_LEDS_MAX_COUNT - 1U, 1U);
+    if ((per_led > 0U) && (status_leds_benchmark_us[0] < budget))
+    {
+        status_leds_benchmark_max_count =
+            (uint16_t)MIN(1U + ((budget - status_leds_benchmark_us[0]) / per_led), 0xFFFFU);
+    }
+
+    stop_animation();
+    status_leds_count = configured_count;
+    status_leds_hw_set_strips(status_leds_settings->status_leds_strips);
+    status_leds_turn_off();
+}
+#endif
+
 /**
  * @brief Turn off all status LEDs.
  *
@@ -862,7 +1408,7 @@ void status_leds_turn_off(void)
     // Stop any animations
     stop_animation();
 
-    if (LCM_SUCCESS != status_leds_set_color(&colors.black, 0U, STATUS_LEDS_COUNT - 1U))
+    if (LCM_SUCCESS != status_leds_set_color(&colors.black, 0U, status_leds_count - 1U))
     {
         fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
     }
@@ -876,6 +1422,12 @@ void status_leds_turn_off(void)
 void status_leds_disable_lights_callback(void)
 {
     status_leds_turn_off();
+
+    // Send the black frame now, the hardware ignores refreshes once disabled.
+    // This is the only place that waits for the previous frame to go out.
+    while (status_leds_hw_busy())
+        ;
+    status_leds_flush();
     status_leds_hw_enable(false);
 }
 
@@ -888,6 +1440,79 @@ EVENT_HANDLER(status_leds, state_changed)
     // No else needed, status LEDs are disabled
 }
 
+/**
+ * @brief Feeds the live modulation of the animations from the telemetry
+ *
+ * Only the modulation level is updated, the running animation picks it up on
+ * its next frame, so a changing RPM never restarts the animation.
+ */
+static void status_leds_update_modulation(void)
+{
+    const vesc_telemetry_t *telemetry = vesc_serial_get_telemetry();
+    int32_t level = 0;
+
+    // Stale telemetry leaves the modulation at rest
+    if (!telemetry->stale)
+    {
+        if ((status_leds_modulation & ANIMATION_MOD_DUTY) != 0U)
+        {
+            level = (telemetry->duty_cycle < 0) ? -telemetry->duty_cycle : telemetry->duty_cycle;
+            level = (level * 255) / STATUS_LEDS_MOD_DUTY_FULL;
+        }
+        else
+        {
+            level = (telemetry->rpm < 0) ? -telemetry->rpm : telemetry->rpm;
+            level = (level * 255) / STATUS_LEDS_MOD_RPM_FULL;
+        }
+    }
+
+    animation_set_modulation((uint8_t)MIN(level, 255));
+}
+
+EVENT_HANDLER(status_leds, telemetry_updated)
+{
+    // Only the battery level is shown on the status LEDs
+    if ((data->telemetry_changed & TELEMETRY_BATTERY_LEVEL) &&
+        status_leds_settings->enable_status_leds)
+    {
+        update_display(event);
+    }
+    // No else needed, nothing to display
+
+    // Movement only modulates the animation that is already running
+    if (data->telemetry_changed & (TELEMETRY_RPM | TELEMETRY_DUTY_CYCLE | TELEMETRY_STALE))
+    {
+        status_leds_update_modulation();
+    }
+    // No else needed, the modulation has not changed
+}
+
+/**
+ * @brief Draws red, green and blue bands across the strip
+ *
+ * The strip is split 3:4:3, rounded to whole LEDs, so the bands fit any
+ * strip length. Two LEDs only show red and blue, and a single LED is green.
+ */
+static void status_leds_show_rgb_bands(void)
+{
+    uint8_t band = (uint8_t)(((status_leds_count * 3U) + 5U) / 10U);
+
+    if (LCM_SUCCESS != status_leds_set_color(&colors.green, 0U, status_leds_count - 1U))
+    {
+        fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
+    }
+    if (band > 0U)
+    {
+        if ((LCM_SUCCESS != status_leds_set_color(&colors.red, 0U, band - 1U)) ||
+            (LCM_SUCCESS !=
+             status_leds_set_color(&colors.blue, status_leds_count - band, status_leds_count - 1U)))
+        {
+            fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
+        }
+    }
+    // No else needed, a single LED is all green
+}
+
 EVENT_HANDLER(status_leds, command)
 {
     switch (event)
@@ -896,11 +1521,13 @@ EVENT_HANDLER(status_leds, command)
         if (status_leds_settings->enable_status_leds)
         {
             status_leds_hw_enable(true);
+            status_leds_invalidate();
             update_display(event);
         }
         else
         {
-            // Fade out the lights and then disable
+            // Fade out whatever is shown and then disable
+            status_leds_flatten();
             fade_animation_setup(status_leds_buffer, STATUS_LEDS_FADE_TO_BLACK_TIMEOUT,
                                  status_leds_disable_lights_callback);
         }
@@ -908,7 +1535,9 @@ EVENT_HANDLER(status_leds, command)
     case EVENT_COMMAND_TOGGLE_BEEPER:
         if (!status_leds_settings->enable_beep)
         {
-            if (LCM_SUCCESS != status_leds_set_color(&colors.red, 0U, STATUS_LEDS_COUNT - 1U))
+            // Flash over the overlays, the callback shows them again
+            status_leds_hide_overlays();
+            if (LCM_SUCCESS != status_leds_set_color(&colors.red, 0U, status_leds_count - 1U))
             {
                 fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
             }
@@ -923,7 +1552,7 @@ EVENT_HANDLER(status_leds, command)
         {
         case COMMAND_PROCESSOR_CONTEXT_BOOT_ANIMATION:
             if (LCM_SUCCESS !=
-                status_leds_set_color(&colors.light_blue, 0U, STATUS_LEDS_COUNT - 1U))
+                status_leds_set_color(&colors.light_blue, 0U, status_leds_count - 1U))
             {
                 fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
             }
@@ -931,7 +1560,7 @@ EVENT_HANDLER(status_leds, command)
                                  status_leds_boot_callback);
             break;
         case COMMAND_PROCESSOR_CONTEXT_IDLE_ANIMATION:
-            if (LCM_SUCCESS != status_leds_set_color(&colors.green, 0U, STATUS_LEDS_COUNT - 1U))
+            if (LCM_SUCCESS != status_leds_set_color(&colors.green, 0U, status_leds_count - 1U))
             {
                 fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
             }
@@ -939,7 +1568,7 @@ EVENT_HANDLER(status_leds, command)
                                  status_leds_idle_default_callback);
             break;
         case COMMAND_PROCESSOR_CONTEXT_DOZING_ANIMATION:
-            if (LCM_SUCCESS != status_leds_set_color(&colors.orange, 0U, STATUS_LEDS_COUNT - 1U))
+            if (LCM_SUCCESS != status_leds_set_color(&colors.orange, 0U, status_leds_count - 1U))
             {
                 fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
             }
@@ -947,7 +1576,7 @@ EVENT_HANDLER(status_leds, command)
                                  status_leds_idle_dozing_callback);
             break;
         case COMMAND_PROCESSOR_CONTEXT_SHUTDOWN_ANIMATION:
-            if (LCM_SUCCESS != status_leds_set_color(&colors.red, 0U, STATUS_LEDS_COUNT - 1U))
+            if (LCM_SUCCESS != status_leds_set_color(&colors.red, 0U, status_leds_count - 1U))
             {
                 fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
             }
@@ -955,7 +1584,7 @@ EVENT_HANDLER(status_leds, command)
                                  status_leds_shutdown_callback);
             break;
         case COMMAND_PROCESSOR_CONTEXT_RIDING_ANIMATION:
-            if (LCM_SUCCESS != status_leds_set_color(&colors.white, 0U, STATUS_LEDS_COUNT - 1U))
+            if (LCM_SUCCESS != status_leds_set_color(&colors.white, 0U, status_leds_count - 1U))
             {
                 fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
             }
@@ -963,21 +1592,7 @@ EVENT_HANDLER(status_leds, command)
                                  status_leds_riding_callback);
             break;
         case COMMAND_PROCESSOR_CONTEXT_PERSONAL_COLOR:
-            if (LCM_SUCCESS !=
-                status_leds_set_color(&colors.red, 0U, 2U)) // Set first 3 LEDs to red
-            {
-                fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
-            }
-            if (LCM_SUCCESS !=
-                status_leds_set_color(&colors.green, 3U, 6U)) // Set middle 4 LEDs to green
-            {
-                fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
-            }
-            if (LCM_SUCCESS !=
-                status_leds_set_color(&colors.blue, 7U, 9U)) // Set last 3 LEDs to blue
-            {
-                fault(EMERGENCY_FAULT_UNEXPECTED_ERROR);
-            }
+            status_leds_show_rgb_bands();
             fade_animation_setup(status_leds_buffer, STATUS_LEDS_FADE_TO_BLACK_TIMEOUT,
                                  status_leds_color_callback);
             break;
@@ -985,7 +1600,7 @@ EVENT_HANDLER(status_leds, command)
             // Turn the status LEDs white and flashing so the user can
             // see the brightness change
             fill_animation_setup(status_leds_buffer, COLOR_MODE_RGB, BRIGHTNESS_MODE_FLASH,
-                                 FILL_MODE_SOLID, 0U, STATUS_LEDS_COUNT - 1U,
+                                 FILL_MODE_SOLID, 0U, status_leds_count - 1U,
                                  0.0f,   // hue min
                                  0.0f,   // hue max
                                  0.0f,   // color change speed
@@ -1006,6 +1621,7 @@ EVENT_HANDLER(status_leds, command)
         {
         case COMMAND_PROCESSOR_CONTEXT_STATUS_BAR_BRIGHTNESS:
             status_leds_hw_set_brightness(status_leds_settings->status_brightness);
+            status_leds_invalidate();
             break;
         case COMMAND_PROCESSOR_CONTEXT_BOOT_ANIMATION:
             status_leds_start_animation_option(status_leds_settings->boot_animation);
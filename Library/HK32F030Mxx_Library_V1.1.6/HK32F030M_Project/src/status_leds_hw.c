@@ -17,31 +17,283 @@
  * with ALCM. If not, see <https://www.gnu.org/licenses/>.
  */
 #include "lcm_types.h"
+#include "config.h"
 #include "status_leds_hw.h"
-#include "interrupts.h"
 #include "hk32f030m.h"
 #include "tiny_math.h"
-#include "vesc_serial.h"
 
 // Implemented in assembly (see ws2812.s)
-extern void ws2812_send_buffer(uint8_t *buffer, uint32_t length);
+extern void ws2812_send_scaled(const uint8_t *buffer, uint32_t length, uint32_t scale,
+                               uint32_t channels);
+extern void ws2812_send_dithered(const uint8_t *buffer, uint32_t length, uint32_t scale,
+                                 const uint16_t *table, uint8_t *residue, uint32_t channels);
+extern void ws2812_latch(void);
 
 // Global brightness scaling
 static uint16_t brightness_scale = 0U;
 static bool_t status_leds_enabled = false;
-static const status_leds_color_t *status_leds_hw_buffer = NULL;
+
+// Index of the white channel of an encoded LED
+#define STATUS_LEDS_W 3U
+
+/**
+ * @brief Channel of the RGBW pixel sent in each position, per channel order
+ */
+static const uint8_t status_leds_swizzle[STATUS_LEDS_ORDER_COUNT][STATUS_LEDS_MAX_CHANNELS] = {
+    [STATUS_LEDS_ORDER_GRB] = {1U, 0U, 2U},
+    [STATUS_LEDS_ORDER_RGB] = {0U, 1U, 2U},
+    [STATUS_LEDS_ORDER_BRG] = {2U, 0U, 1U},
+    [STATUS_LEDS_ORDER_RBG] = {0U, 2U, 1U},
+    [STATUS_LEDS_ORDER_GBR] = {1U, 2U, 0U},
+    [STATUS_LEDS_ORDER_BGR] = {2U, 1U, 0U},
+#ifdef ENABLE_STATUS_LEDS_RGBW
+    [STATUS_LEDS_ORDER_GRBW] = {1U, 0U, 2U, STATUS_LEDS_W},
+    [STATUS_LEDS_ORDER_RGBW] = {0U, 1U, 2U, STATUS_LEDS_W},
+#endif
+};
+
+// Strips on the data line and the frame encoded in their channel orders
+static status_leds_strip_t status_leds_strips[STATUS_LEDS_MAX_STRIPS] = {
+    {.count = STATUS_LEDS_MAX_COUNT, .order = STATUS_LEDS_ORDER_GRB}};
+static uint8_t status_leds_wire[STATUS_LEDS_MAX_COUNT * STATUS_LEDS_MAX_CHANNELS] = {0U};
+static uint16_t status_leds_channels = 0U;
+
+#ifdef ENABLE_STATUS_LEDS_GAMMA
+/**
+ * @brief Gamma 2.2 correction table, 255 * (i / 255)^2.2 in Q8.8
+ *
+ * The 8 fractional bits are not thrown away: they are carried from frame to
+ * frame per channel (see status_leds_dither) so that levels between two
+ * output steps are shown as a mix of both.
+ */
+static const uint16_t gamma_table[256] = {
+    0, 0, 2, 4, 7, 11, 17, 24, 32, 42, 53, 65,
+    78, 94, 110, 128, 148, 169, 191, 216, 241, 269, 298, 328,
+    360, 394, 430, 467, 506, 547, 589, 633, 679, 726, 776, 827,
+    880, 934, 991, 1049, 1109, 1171, 1235, 1300, 1368, 1437, 1508, 1581,
+    1656, 1733, 1812, 1893, 1975, 2060, 2146, 2235, 2325, 2417, 2512, 2608,
+    2706, 2806, 2908, 3013, 3119, 3227, 3337, 3450, 3564, 3680, 3798, 3919,
+    4041, 4166, 4292, 4421, 4552, 4685, 4819, 4956, 5096, 5237, 5380, 5525,
+    5673, 5823, 5974, 6128, 6284, 6442, 6603, 6765, 6930, 7097, 7266, 7437,
+    7610, 7786, 7963, 8143, 8325, 8509, 8696, 8885, 9075, 9268, 9464, 9661,
+    9861, 10063, 10267, 10474, 10682, 10893, 11107, 11322, 11540, 11760, 11982, 12207,
+    12433, 12663, 12894, 13128, 13363, 13602, 13842, 14085, 14330, 14578, 14827, 15080,
+    15334, 15591, 15850, 16111, 16375, 16641, 16909, 17180, 17453, 17729, 18006, 18287,
+    18569, 18854, 19141, 19431, 19723, 20017, 20314, 20613, 20915, 21218, 21525, 21833,
+    22144, 22458, 22774, 23092, 23413, 23736, 24062, 24390, 24720, 25053, 25388, 25726,
+    26066, 26408, 26753, 27101, 27451, 27803, 28158, 28515, 28875, 29237, 29602, 29969,
+    30338, 30710, 31085, 31462, 31841, 32223, 32608, 32995, 33384, 33776, 34170, 34567,
+    34967, 35369, 35773, 36180, 36589, 37001, 37416, 37833, 38252, 38674, 39099, 39526,
+    39956, 40388, 40823, 41260, 41700, 42142, 42587, 43034, 43484, 43937, 44392, 44849,
+    45310, 45772, 46238, 46706, 47176, 47649, 48125, 48603, 49084, 49567, 50053, 50542,
+    51033, 51526, 52023, 52522, 53023, 53527, 54034, 54543, 55055, 55570, 56087, 56607,
+    57129, 57654, 58182, 58712, 59245, 59780, 60318, 60859, 61402, 61948, 62497, 63048,
+    63602, 64159, 64718, 65280};
+
+// Fractional part of each channel left over from the previous frame
+static uint8_t status_leds_dither[sizeof(status_leds_wire)] = {0U};
+#endif
+
+#ifdef ENABLE_STATUS_LEDS_SPI
+// Pin carrying the LED data, it must be able to take the SPI1_MOSI function
+#define STATUS_LEDS_SPI_PORT GPIOD
+#define STATUS_LEDS_SPI_PIN GPIO_Pin_4
+#define STATUS_LEDS_SPI_PIN_SOURCE GPIO_PinSource4
+#define STATUS_LEDS_SPI_AF GPIO_AF_2
+
+/**
+ * @brief Number of all zero SPI frames sent after the pixels (4 us each), long
+ * enough for the strip to latch the new colors.
+ */
+#define STATUS_LEDS_SPI_RESET_FRAMES 16U
+
+/**
+ * @brief WS2812 waveform for each nibble of a channel
+ *
+ * SPI1 runs at 4 MHz and every data bit is sent as a 4 bit symbol (1 us): a
+ * 0 is 1000 (0.25 us high) and a 1 is 1110 (0.75 us high). A 16 bit SPI frame
+ * carries one nibble, so each channel is two frames.
+ */
+static const uint16_t ws2812_spi_nibble[16] = {
+    0x8888, 0x888E, 0x88E8, 0x88EE, 0x8E88, 0x8E8E, 0x8EE8, 0x8EEE,
+    0xE888, 0xE88E, 0xE8E8, 0xE8EE, 0xEE88, 0xEE8E, 0xEEE8, 0xEEEE};
+
+// Transmit state, shared with the SPI1 interrupt. The encoded frame is only
+// read by the interrupt and is not written to until the transfer is done.
+static volatile bool_t status_leds_spi_busy = false;
+static uint16_t status_leds_spi_frame = 0U;
+static uint8_t status_leds_spi_byte = 0U;
+
+/**
+ * @brief Returns the byte to send for a channel of the strip, scaled by the
+ * global brightness (and gamma corrected and dithered when enabled).
+ *
+ * @param channel Index of the channel (byte) in the buffer
+ */
+static uint8_t status_leds_hw_level(uint16_t channel)
+{
+    const uint8_t *source = status_leds_wire;
+#ifdef ENABLE_STATUS_LEDS_GAMMA
+    uint16_t level =
+        (uint16_t)((gamma_table[source[channel]] * (uint32_t)brightness_scale) >> 8U) +
+        status_leds_dither[channel];
+    status_leds_dither[channel] = (uint8_t)(level & 0xFFU);
+    return (uint8_t)(level >> 8U);
+#else
+    return (uint8_t)((source[channel] * brightness_scale) >> 8U);
+#endif
+}
+
+/**
+ * @brief SPI1 transmit interrupt, keeps the TX FIFO topped up with the
+ * encoded pixels followed by the reset frames.
+ *
+ * The interrupt streams status_leds_wire, scaling each channel and
+ * expanding it to SPI bit patterns as it goes. status_leds_wire is only
+ * rewritten while status_leds_spi_busy is clear, so it does not change under
+ * the interrupt. Once the frame has been latched the interrupt is turned off
+ * again and status_leds_spi_busy is cleared.
+ */
+void status_leds_hw_spi_irq(void)
+{
+    // TXE stays set while there is room in the FIFO for another frame
+    while (SPI1->SR & SPI_SR_TXE)
+    {
+        uint16_t frame = 0U;
+
+        if (status_leds_spi_frame < (2U * status_leds_channels))
+        {
+            if ((status_leds_spi_frame & 1U) == 0U)
+            {
+                status_leds_spi_byte = status_leds_hw_level(status_leds_spi_frame >> 1U);
+                frame = ws2812_spi_nibble[status_leds_spi_byte >> 4U];
+            }
+            else
+            {
+                frame = ws2812_spi_nibble[status_leds_spi_byte & 0x0FU];
+            }
+        }
+        else if (status_leds_spi_frame >=
+                 (2U * status_leds_channels + STATUS_LEDS_SPI_RESET_FRAMES))
+        {
+            SPI1->CR2 &= ~SPI_CR2_TXEIE;
+            status_leds_spi_busy = false;
+            break;
+        }
+        // Else, still sending the reset frames (all zero)
+
+        SPI1->DR = frame;
+        status_leds_spi_frame++;
+    }
+}
+#endif
+
+/**
+ * @brief Returns the number of channels (bytes) sent per LED of a strip.
+ *
+ * @param strip Strip descriptor
+ * @return 4 for strips with a white channel, otherwise 3
+ */
+static uint8_t status_leds_hw_strip_channels(const status_leds_strip_t *strip)
+{
+#ifdef ENABLE_STATUS_LEDS_RGBW
+    return (status_leds_swizzle[strip->order][STATUS_LEDS_W] == STATUS_LEDS_W) ? 4U : 3U;
+#else
+    (void)strip;
+    return 3U;
+#endif
+}
+
+/**
+ * @brief Encodes a frame in the channel order of each strip.
+ *
+ * Done in a single pass over the frame. On strips with a white channel the
+ * part of the color common to red, green and blue is sent on the white LED
+ * and taken off the others.
+ *
+ * @param frame RGB frame with an entry for every LED on the strips
+ * @return Number of channels (bytes) encoded
+ */
+static uint16_t status_leds_hw_encode(const status_leds_color_t *frame)
+{
+    uint8_t *wire = status_leds_wire;
+
+    for (uint8_t s = 0; s < STATUS_LEDS_MAX_STRIPS; s++)
+    {
+        const uint8_t *swizzle = status_leds_swizzle[status_leds_strips[s].order];
+        const uint8_t channels = status_leds_hw_strip_channels(&status_leds_strips[s]);
+
+        for (uint8_t i = 0; i < status_leds_strips[s].count; i++)
+        {
+            uint8_t pixel[4] = {frame->r, frame->g, frame->b, 0U};
+
+#ifdef ENABLE_STATUS_LEDS_RGBW
+            if (channels == 4U)
+            {
+                pixel[STATUS_LEDS_W] = MIN(MIN(pixel[0], pixel[1]), pixel[2]);
+                pixel[0] -= pixel[STATUS_LEDS_W];
+                pixel[1] -= pixel[STATUS_LEDS_W];
+                pixel[2] -= pixel[STATUS_LEDS_W];
+            }
+#endif
+            for (uint8_t c = 0; c < channels; c++)
+            {
+                *wire++ = pixel[swizzle[c]];
+            }
+            frame++;
+        }
+    }
+
+    return (uint16_t)(wire - status_leds_wire);
+}
 
 /**
  * @brief Initializes the status LEDs hardware module.
  *
  * This function initializes the status LEDs hardware and prepares it for use.
  */
-void status_leds_hw_init(const status_leds_color_t *buffer)
+void status_leds_hw_init(void)
 {
     GPIO_InitTypeDef GPIO_InitStructure = {0U};
     GPIO_StructInit(&GPIO_InitStructure);
 
     RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOD, ENABLE);
+#ifdef ENABLE_STATUS_LEDS_SPI
+    SPI_InitTypeDef SPI_InitStructure = {0U};
+    NVIC_InitTypeDef NVIC_InitStructure = {0U};
+
+    // Drive the data line from SPI1 MOSI
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF;
+    GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
+    GPIO_InitStructure.GPIO_Pin = STATUS_LEDS_SPI_PIN;
+    GPIO_InitStructure.GPIO_PuPd = GPIO_PuPd_NOPULL;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_10MHz;
+    GPIO_Init(STATUS_LEDS_SPI_PORT, &GPIO_InitStructure);
+    GPIO_PinAFConfig(STATUS_LEDS_SPI_PORT, STATUS_LEDS_SPI_PIN_SOURCE, STATUS_LEDS_SPI_AF);
+
+    // 32 MHz / 8 = 4 MHz, 16 bit frames, transmit only
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_SPI1, ENABLE);
+    SPI_StructInit(&SPI_InitStructure);
+    SPI_InitStructure.SPI_Direction = SPI_Direction_1Line_Tx;
+    SPI_InitStructure.SPI_Mode = SPI_Mode_Master;
+    SPI_InitStructure.SPI_DataSize = SPI_DataSize_16b;
+    SPI_InitStructure.SPI_CPOL = SPI_CPOL_Low;
+    SPI_InitStructure.SPI_CPHA = SPI_CPHA_1Edge;
+    SPI_InitStructure.SPI_NSS = SPI_NSS_Soft;
+    SPI_InitStructure.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_8;
+    SPI_InitStructure.SPI_FirstBit = SPI_FirstBit_MSB;
+    SPI_Init(SPI1, &SPI_InitStructure);
+    SPI_Cmd(SPI1, ENABLE);
+
+    // The FIFO holds about 8 us of data, so the interrupt has to be serviced
+    // promptly to avoid gaps in the frame
+    NVIC_InitStructure.NVIC_IRQChannel = SPI1_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+
+    brightness_scale = 0U;
+#else
     GPIO_InitStructure.GPIO_Mode = GPIO_Mode_OUT;
     GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
     GPIO_InitStructure.GPIO_Pin = GPIO_Pin_4;
@@ -52,47 +304,113 @@ void status_leds_hw_init(const status_leds_color_t *buffer)
     // Initialize the status LEDs
     brightness_scale = 0U;
     GPIOD->BSRR = GPIO_Pin_4 << 16U;
+#endif
+}
+
+#ifdef ENABLE_STATUS_LEDS_SPI
+bool_t status_leds_hw_busy(void)
+{
+    return status_leds_spi_busy;
+}
 
-    // Set the buffer to the provided buffer
-    status_leds_hw_buffer = buffer;
+void status_leds_hw_refresh(const status_leds_color_t *frame)
+{
+    // The SPI1 interrupt is off while the link is idle, so the frame can be
+    // encoded without a critical section. A frame given while busy is
+    // dropped, callers wait for status_leds_hw_busy() to clear.
+    if ((frame != NULL) && status_leds_enabled && !status_leds_spi_busy)
+    {
+        status_leds_channels = status_leds_hw_encode(frame);
+        status_leds_spi_frame = 0U;
+        status_leds_spi_busy = true;
+
+        // Make the transmit state visible before the interrupt can run
+        __DMB();
+        SPI1->CR2 |= SPI_CR2_TXEIE;
+    }
+}
+#else
+bool_t status_leds_hw_busy(void)
+{
+    // The frame has been sent by the time status_leds_hw_refresh() returns
+    return false;
 }
 
-void status_leds_hw_update(void)
+void status_leds_hw_refresh(const status_leds_color_t *frame)
 {
-    if (status_leds_hw_buffer != NULL)
+    if ((frame != NULL) && status_leds_enabled)
     {
-        if (status_leds_enabled)
-        {
-            status_leds_color_t scaled_buffer[STATUS_LEDS_COUNT];
+        uint16_t sent = 0U;
 
-            // Scale LEDs by global brightness
-            for (uint8_t i = 0U; i < STATUS_LEDS_COUNT; i++)
-            {
-                scaled_buffer[i].r = (status_leds_hw_buffer[i].r * brightness_scale) >> 8U;
-                scaled_buffer[i].g = (status_leds_hw_buffer[i].g * brightness_scale) >> 8U;
-                scaled_buffer[i].b = (status_leds_hw_buffer[i].b * brightness_scale) >> 8U;
-            }
+        status_leds_channels = status_leds_hw_encode(frame);
+
+        // The sender disables interrupts while each LED is bit-banged and
+        // opens a short window between LEDs, so incoming VESC data is not
+        // lost and the refresh does not have to wait for the link to go idle.
+        // Each strip is sent with its own LED size and the chain is latched
+        // once at the end.
+        for (uint8_t s = 0; s < STATUS_LEDS_MAX_STRIPS; s++)
+        {
+            const uint8_t channels = status_leds_hw_strip_channels(&status_leds_strips[s]);
+            const uint16_t length = (uint16_t)(status_leds_strips[s].count * channels);
 
-            // Disable interrupts to prevent timing issues while bitbanging the
-            // LEDs.
-            interrupts_disable();
-            ws2812_send_buffer((uint8_t *)scaled_buffer,
-                               STATUS_LEDS_COUNT * sizeof(status_leds_color_t));
-            interrupts_enable();
+#ifdef ENABLE_STATUS_LEDS_GAMMA
+            // Gamma correct, scale by global brightness and add the error
+            // left over from the last frame while sending. The integer part
+            // is sent and the new fraction is kept for the next frame.
+            ws2812_send_dithered(&status_leds_wire[sent], length, brightness_scale, gamma_table,
+                                 &status_leds_dither[sent], channels);
+#else
+            // Scale LEDs by global brightness while sending
+            ws2812_send_scaled(&status_leds_wire[sent], length, brightness_scale, channels);
+#endif
+            sent += length;
         }
+        ws2812_latch();
     }
 }
+#endif
 
-void status_leds_hw_refresh()
+/**
+ * @brief Sets the strips chained on the data line.
+ *
+ * @param strips STATUS_LEDS_MAX_STRIPS strip descriptors with at most
+ * STATUS_LEDS_MAX_COUNT LEDs together. Takes effect from the next frame.
+ */
+void status_leds_hw_set_strips(const status_leds_strip_t *strips)
 {
-    if (LCM_SUCCESS == vesc_serial_check_busy_and_set_callback(status_leds_hw_update))
+    for (uint8_t s = 0; s < STATUS_LEDS_MAX_STRIPS; s++)
     {
-        // All clear, update the LEDs
-        status_leds_hw_update();
+        status_leds_strips[s] = strips[s];
     }
-    // Else, VESC serial is busy and we will update the LEDs when it is free
 }
 
+#ifdef ENABLE_STATUS_LEDS_BENCHMARK
+// Milliseconds since boot, counted by the SysTick interrupt
+extern volatile uint32_t systick_ms;
+
+/**
+ * @brief Returns the time since boot in microseconds, for timing frames.
+ *
+ * The millisecond count is extended with the position of the SysTick counter
+ * within the current millisecond.
+ */
+uint32_t status_leds_hw_micros(void)
+{
+    uint32_t ms = 0U;
+    uint32_t elapsed = 0U;
+
+    // Read again if the millisecond count changed between the two reads
+    do
+    {
+        ms = systick_ms;
+        elapsed = SysTick->LOAD - SysTick->VAL;
+    } while (ms != systick_ms);
+
+    return (ms * 1000U) + ((elapsed * 1000U) / (SysTick->LOAD + 1U));
+}
+#endif
+
 /**
  * @brief Sets the global brightness of the status LEDs.
  *
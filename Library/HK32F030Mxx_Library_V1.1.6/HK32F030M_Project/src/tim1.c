@@ -25,7 +25,7 @@ lcm_status_t TIM1_init(void)
     RCC_APB2PeriphClockCmd(RCC_APB2Periph_TIM1, ENABLE);
     TIM_TimeBaseStructInit(&TIM_TimeBaseStructure);
 
-    TIM_TimeBaseStructure.TIM_Prescaler = 32 - 1;
+    TIM_TimeBaseStructure.TIM_Prescaler = TIM1_PRESCALER - 1;
     TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
     TIM_TimeBaseStructure.TIM_Period = TIM1_PERIOD - 1;
     TIM_TimeBaseStructure.TIM_ClockDivision = 0;
@@ -45,41 +45,53 @@
 #define VESC_SERIAL_RX_BUFFER_SIZE 128U
 #define POLLING_INTERVAL_MS 250U
 
+/* After a communication timeout the VESC is probed quickly, so a brief
+ * glitch (e.g. a connector bouncing) is recovered from in tens of ms, and
+ * then with an exponential backoff in case it is really gone. */
+#define PROBE_INTERVAL_MS 10U
+#define PROBE_FAST_COUNT 5U
+#define PROBE_MAX_INTERVAL_MS 2000U
+
 #define START_BYTE 0x02
 #define END_BYTE 0x03
 #define MAX_PACKET_LENGTH 32
 #define MAX_OUTSTANDING_PACKETS 5
-#define SIGNIFICANT_CHANGE(x, y) (fabsf((x) - (y)) > 0.02f)
-#define RADIANS_TO_DEGREES(radians) ((radians) * (180.0f / M_PI))
+
+/* 18000 / pi, in Q2, used to convert radians to centidegrees. Kept below
+ * 2^15 so it can be multiplied by a 16-bit mantissa without overflowing. */
+#define RADIANS_TO_CENTIDEGREES_Q2 22918U
+#define RADIANS_TO_CENTIDEGREES_SHIFT 2
 
 typedef struct
 {
-    float32_t duty_cycle;
+    int16_t duty_cycle;
     int32_t rpm;
 #if defined(ENABLE_VOLTAGE_MONITORING)
-    float32_t input_voltage;
+    int16_t input_voltage;
 #endif
-    float32_t battery_level;
+    int16_t battery_level;
     uint8_t fault;
 } comm_get_values_setup_selective_t;
 
 #ifdef ENABLE_IMU_EVENTS
 typedef struct
 {
-    float32_t pitch;
-    float32_t roll;
+    int16_t pitch;
+    int16_t roll;
 } comm_get_imu_data_t;
 #endif
 
 static volatile ring_buffer_t vesc_serial_rx_buffer = {0};
 static volatile uint8_t vesc_serial_rx_buffer_data[VESC_SERIAL_RX_BUFFER_SIZE] = {0};
 static timer_id_t vesc_serial_tx_timerid = INVALID_TIMER_ID;
-static comm_get_values_setup_selective_t comm_get_values_setup_selective = {0};
+static vesc_telemetry_t vesc_telemetry = {0};
 static bool_t vesc_alive = false;
 static uint8_t vesc_serial_outstaning_packet_count = 0;
-static vesc_serial_callback_t vesc_serial_callback = NULL;
+static uint16_t vesc_serial_probe_interval = 0U; // 0 when not probing
+static uint8_t vesc_serial_probe_count = 0U;
 #ifdef ENABLE_IMU_EVENTS
-static comm_get_imu_data_t comm_get_imu_data = {0};
+static board_mode_mask_t vesc_serial_imu_demand = 0U; // Modes where IMU data is needed
+static bool_t vesc_serial_imu_needed = false;          // IMU data needed in current mode
 #endif
 
 // Forward declarations
@@ -91,8 +103,8 @@ TIMER_CALLBACK(vesc_serial, tx);
  * @brief Initializes the VESC serial module
  *
  * Initializes the VESC serial module by initializing the ring buffer,
- * subscribing to the VESC serial data event, and initializing the
- * comm_get_values_setup_selective struct.
+ * subscribing to the VESC serial data event, and clearing the telemetry
+ * snapshot.
  */
 lcm_status_t vesc_serial_init(void)
 {
@@ -105,13 +117,13 @@ lcm_status_t vesc_serial_init(void)
     vesc_serial_rx_buffer.write_idx = 0U;
 
     // Initialize local data structures 
-    memset(&comm_get_values_setup_selective, 0, sizeof(comm_get_values_setup_selective));
-#ifdef ENABLE_IMU_EVENTS
-    memset(&comm_get_imu_data, 0, sizeof(comm_get_imu_data));
-#endif
+    memset(&vesc_telemetry, 0, sizeof(vesc_telemetry));
 
     // Assume VESC is not alive
     vesc_alive = false;
+    vesc_serial_outstaning_packet_count = 0U;
+    vesc_serial_probe_interval = 0U;
+    vesc_serial_tx_timerid = INVALID_TIMER_ID;
 
     vesc_serial_hw_init(SERIAL_BAUDRATE);
 
@@ -123,38 +135,55 @@ lcm_status_t vesc_serial_init(void)
 }
 
 /**
- * @brief Clears the outstanding packets count and calls the callback if set
+ * @brief Clears the outstanding packets count
  *
  * This function is called when the VESC serial module is no longer busy.
- * It clears the outstanding packet count and calls the callback if it is set.
  */
 void clear_outstanding_packets(void)
 {
-    // If someone is waiting for a callback, call it now
-    if (vesc_serial_callback != NULL)
-    {
-        vesc_serial_callback();
-        vesc_serial_callback = NULL;
-    }
     vesc_serial_outstaning_packet_count = 0;
 }
 
 /**
- * @brief Checks if the VESC serial is busy and sets a callback if it is
- * busy.
+ * @brief Starts probing for the VESC after a communication timeout
+ *
+ * The last known telemetry is kept, but marked as stale so consumers can
+ * tell it is no longer live. The polling timer is then switched to the fast
+ * probe interval.
  */
-lcm_status_t vesc_serial_check_busy_and_set_callback(vesc_serial_callback_t callback)
+static void start_probing(void)
 {
-    lcm_status_t status = LCM_SUCCESS;
+    event_data_t telemetry_data = {0};
+
+    vesc_telemetry.stale = true;
+    telemetry_data.telemetry_changed = TELEMETRY_STALE;
+    event_queue_push(EVENT_TELEMETRY_UPDATED, &telemetry_data);
 
-    // If the VESC is alive and we are busy, set the callback
-    if ((vesc_alive == true) && (vesc_serial_outstaning_packet_count > 0U))
+    vesc_serial_probe_count = 0U;
+    vesc_serial_probe_interval = PROBE_INTERVAL_MS;
+    vesc_serial_tx_timerid =
+        set_timer(vesc_serial_probe_interval, TIMER_CALLBACK_NAME(vesc_serial, tx), true);
+}
+
+/**
+ * @brief Backs off the probe interval after an unanswered probe
+ *
+ * The first few probes are sent at the fast interval. After that, the
+ * interval is doubled on each probe until it reaches the maximum.
+ */
+static void backoff_probing(void)
+{
+    if (vesc_serial_probe_count < PROBE_FAST_COUNT)
     {
-        status = LCM_BUSY;
-        vesc_serial_callback = callback;
+        vesc_serial_probe_count++;
     }
-
-    return status;
+    else if (vesc_serial_probe_interval < PROBE_MAX_INTERVAL_MS)
+    {
+        vesc_serial_probe_interval = MIN(vesc_serial_probe_interval * 2U, PROBE_MAX_INTERVAL_MS);
+        vesc_serial_tx_timerid =
+            set_timer(vesc_serial_probe_interval, TIMER_CALLBACK_NAME(vesc_serial, tx), true);
+    }
+    // No else needed, already probing at the slowest rate
 }
 
 /**
@@ -228,55 +257,84 @@ uint32_t buffer_get_uint32(const uint8_t *buffer)
     return (buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
 }
 
+#ifdef ENABLE_IMU_EVENTS
 /**
- * @brief Extracts a 16-bit float from a buffer
+ * @brief Extracts an angle in radians from a buffer as centidegrees
  *
- * Extracts a 16-bit signed integer from the buffer and scales it to a float32_t.
+ * The VESC sends IMU angles as raw IEEE 754 single precision floats. Rather
+ * than pulling in the soft-float library to convert them, the mantissa is
+ * truncated to 16 bits and scaled by 18000/pi with integer math. That leaves
+ * well over the precision needed for a 0.01 degree result.
  *
  * @param buffer The buffer to read from
- * @param scale The scale of the float (i.e. 100.0 for a 1/100th scaling)
- * @return The scaled float
+ * @return The angle in 0.01 degree units, saturated to the int16_t range
  */
-float16_t buffer_get_float16(const uint8_t *buffer, float32_t scale)
+int16_t buffer_get_radians_as_centidegrees(const uint8_t *buffer)
 {
-    return (float16_t)buffer_get_int16(buffer) / scale;
+    uint32_t bits = buffer_get_uint32(buffer);
+    int16_t exponent = (int16_t)((bits >> 23) & 0xFFU);
+    uint32_t mantissa = ((bits & 0x7FFFFFU) | 0x800000U) >> 8;
+    uint32_t magnitude = 0U;
+
+    // The mantissa is now 16 bits with the binary point after the top bit, so
+    // the value is mantissa * 2^(exponent - 127 - 15).
+    int16_t shift = exponent - (127 + 15 + RADIANS_TO_CENTIDEGREES_SHIFT);
+
+    if (exponent == 0)
+    {
+        // Zero or denormal, both are zero for our purposes
+        magnitude = 0U;
+    }
+    else if (shift >= 0)
+    {
+        // Far too large to be an angle (includes infinity and NaN)
+        magnitude = INT16_MAX;
+    }
+    else if (shift > -32)
+    {
+        magnitude = (mantissa * RADIANS_TO_CENTIDEGREES_Q2) >> -shift;
+        magnitude = MIN(magnitude, (uint32_t)INT16_MAX);
+    }
+    // No else needed, too small to register
+
+    return (bits & 0x80000000U) ? -(int16_t)magnitude : (int16_t)magnitude;
 }
+#endif
 
 /**
- * @brief Extracts a 32-bit float from a buffer
+ * @brief Checks if a telemetry value has moved outside of its deadband
  *
- * Extracts a 32-bit signed integer from the buffer and scales it to a float32_t.
+ * Both values must be in the same units as the deadband. Settling to exactly
+ * zero is always reported, since the board mode relies on seeing zero RPM to
+ * know the board has stopped.
  *
- * @param buffer The buffer to read from
- * @param scale The scale of the float (i.e. 100.0 for a 1/100th scaling)
- * @return The scaled float
+ * @param value The freshly decoded value
+ * @param reported The last value that was reported with an event
+ * @param deadband The smallest change that is worth reporting
+ * @return true if the change should be reported, false otherwise
  */
-float16_t buffer_get_float32(const uint8_t *buffer, float32_t scale)
-{
-    return (float32_t)buffer_get_int32(buffer) / scale;
-}
-
-float32_t buffer_get_float32_auto(const uint8_t *buffer)
+static bool_t telemetry_changed(int32_t value, int32_t reported, int32_t deadband)
 {
-    union { uint32_t i; float f; } u;
-    u.i = buffer_get_uint32(buffer);
-    return (float32_t)u.f;
+    int32_t delta = value - reported;
+    return ((delta >= deadband) || (delta <= -deadband) || ((value == 0) && (reported != 0)));
 }
 
 #ifdef ENABLE_IMU_EVENTS
 /**
  * @brief Processes a COMM_GET_IMU_DATA packet
  *
- * This function is an event handler for the EVENT_SERIAL_DATA_RX event.
- * It copies the payload into a temporary struct and then checks if each field
- * has changed. If a field has changed, it pushes an event to the event queue
- * and updates the comm_get_imu_data struct.
+ * Decodes the payload into a temporary struct and then checks if each field
+ * has moved outside of its deadband. If it has, the telemetry snapshot is
+ * updated and the field is added to the changed mask.
+ *
  * @param payload The payload of the packet
  * @param packet_length The length of the packet
+ * @return The mask of telemetry fields that changed
  */
-void process_comm_get_imu_data(const uint8_t *payload, uint8_t packet_length)
+telemetry_fields_t process_comm_get_imu_data(const uint8_t *payload, uint8_t packet_length)
 {
     comm_get_imu_data_t imu_data = {0};
+    telemetry_fields_t changed = TELEMETRY_NONE;
     uint16_t mask = 0;
 
     // Expect a specific packet length for the fields selected.
@@ -285,7 +343,7 @@ void process_comm_get_imu_data(const uint8_t *payload, uint8_t packet_length)
     if (packet_length != COMM_GET_IMU_DATA_RESPONSE_LENGTH)
     {
         fault(EMERGENCY_FAULT_INVALID_LENGTH);
-        return;
+        return TELEMETRY_NONE;
     }
 
     // Response contains a 16-bit mask of the fields we requested
@@ -294,47 +352,50 @@ void process_comm_get_imu_data(const uint8_t *payload, uint8_t packet_length)
     {
         // Invalid mask
         fault(EMERGENCY_FAULT_OUT_OF_BOUNDS);
-        return;
+        return TELEMETRY_NONE;
     }
 
-    // Copy the payload into the temporary comm_get_imu_data struct
-    imu_data.roll = buffer_get_float32_auto(&payload[3]);
-    imu_data.pitch = buffer_get_float32_auto(&payload[7]);
+    // Copy the payload into the temporary comm_get_imu_data struct. The VESC
+    // reports radians, but everything downstream works in centidegrees, so
+    // convert once here before comparing against the last reported values.
+    imu_data.roll = buffer_get_radians_as_centidegrees(&payload[3]);
+    imu_data.pitch = buffer_get_radians_as_centidegrees(&payload[7]);
 
     // For each field, check if the value has changed
-    if SIGNIFICANT_CHANGE(imu_data.pitch, comm_get_imu_data.pitch)
+    if (telemetry_changed(imu_data.pitch, vesc_telemetry.imu_pitch, TELEMETRY_IMU_ANGLE_DEADBAND))
     {
-        event_data_t data = {0};
-        data.imu_pitch = RADIANS_TO_DEGREES(imu_data.pitch);
-        event_queue_push(EVENT_IMU_PITCH_CHANGED, &data);
-
-        comm_get_imu_data.pitch = data.imu_pitch;
+        vesc_telemetry.imu_pitch = imu_data.pitch;
+        changed |= TELEMETRY_IMU_PITCH;
     }
 
-    if SIGNIFICANT_CHANGE(imu_data.roll, comm_get_imu_data.roll)
+    if (telemetry_changed(imu_data.roll, vesc_telemetry.imu_roll, TELEMETRY_IMU_ANGLE_DEADBAND))
     {
-        event_data_t data = {0};
-        data.imu_roll = RADIANS_TO_DEGREES(imu_data.roll);
-        event_queue_push(EVENT_IMU_ROLL_CHANGED, &data);
-
-        comm_get_imu_data.roll = data.imu_roll;
+        vesc_telemetry.imu_roll = imu_data.roll;
+        changed |= TELEMETRY_IMU_ROLL;
     }
+
+    vesc_telemetry.sequence++;
+    return changed;
 }
 #endif
 
 /**
  * @brief Processes a COMM_GET_VALUES_SETUP_SELECTIVE packet
  *
- * This function is an event handler for the EVENT_SERIAL_DATA_RX event.
- * It copies the payload into a temporary struct and then checks if each field
- * has changed. If a field has changed, it pushes an event to the event queue
- * and updates the comm_get_values_setup_selective struct.
+ * Decodes the payload into a temporary struct and then checks if each field
+ * has moved outside of its deadband. If it has, the telemetry snapshot is
+ * updated and the field is added to the changed mask. The fault code is not
+ * filtered; any change is reported.
+ *
  * @param payload The payload of the packet
  * @param packet_length The length of the packet
+ * @return The mask of telemetry fields that changed
  */
-void process_comm_get_values_setup_selective(const uint8_t *payload, uint8_t packet_length)
+telemetry_fields_t process_comm_get_values_setup_selective(const uint8_t *payload,
+                                                           uint8_t packet_length)
 {
     comm_get_values_setup_selective_t values = {0};
+    telemetry_fields_t changed = TELEMETRY_NONE;
     uint32_t values_mask = 0;
 
     // Expect a specific packet length for the fields selected.
@@ -343,7 +404,7 @@ void process_comm_get_values_setup_selective(const uint8_t *payload, uint8_t pac
     if (packet_length != COMM_GET_VALUES_SETUP_SELECTIVE_RESPONSE_LENGTH)
     {
         fault(EMERGENCY_FAULT_INVALID_LENGTH);
-        return;
+        return TELEMETRY_NONE;
     }
 
     // Response contains a 32-bit mask of the fields we requested
@@ -352,78 +413,68 @@ void process_comm_get_values_setup_selective(const uint8_t *payload, uint8_t pac
     {
         // Invalid mask
         fault(EMERGENCY_FAULT_OUT_OF_BOUNDS);
-        return;
+        return TELEMETRY_NONE;
     }
 
     // Copy the payload into the temporary comm_get_values_setup_selective
-    // struct
-    values.duty_cycle = buffer_get_float16(&payload[5], 10.0f);
+    // struct. The VESC already sends these as scaled integers (duty cycle,
+    // voltage and battery level in tenths), so they are kept as-is.
+    values.duty_cycle = buffer_get_int16(&payload[5]);
 
     // Coerce the duty cycle to a valid range
-    CLAMP(values.duty_cycle, -100.0f, 100.0f);
+    values.duty_cycle = CLAMP(values.duty_cycle, -1000, 1000);
 
-    values.rpm = buffer_get_float32(&payload[7], 1.0f);
+    values.rpm = buffer_get_int32(&payload[7]);
 
 #if defined(ENABLE_VOLTAGE_MONITORING)
-    values.input_voltage = buffer_get_float16(&payload[11], 10.0f);
+    values.input_voltage = buffer_get_int16(&payload[11]);
 #endif
-    values.battery_level = buffer_get_float16(&payload[13], 10.0f);
+    values.battery_level = buffer_get_int16(&payload[13]);
 
     // The VESC can return battery levels outside of the 0-100% range,
     // so we need to coerce it to a valid range.
-    CLAMP(values.battery_level, 0.0f, 100.0f);
+    values.battery_level = CLAMP(values.battery_level, 0, 1000);
 
     values.fault = payload[15];
 
     // For each field, check if the value has changed
-    if (values.duty_cycle != comm_get_values_setup_selective.duty_cycle)
+    if (telemetry_changed(values.duty_cycle, vesc_telemetry.duty_cycle,
+                          TELEMETRY_DUTY_CYCLE_DEADBAND))
     {
-        event_data_t data = {0};
-        data.duty_cycle = values.duty_cycle;
-        event_queue_push(EVENT_DUTY_CYCLE_CHANGED, &data);
-
-        comm_get_values_setup_selective.duty_cycle = values.duty_cycle;
+        vesc_telemetry.duty_cycle = values.duty_cycle;
+        changed |= TELEMETRY_DUTY_CYCLE;
     }
 
-    if (values.rpm != comm_get_values_setup_selective.rpm)
+    if (telemetry_changed(values.rpm, vesc_telemetry.rpm, TELEMETRY_RPM_DEADBAND))
     {
-        event_data_t data = {0};
-        data.rpm = values.rpm;
-        event_queue_push(EVENT_RPM_CHANGED, &data);
-
-        comm_get_values_setup_selective.rpm = values.rpm;
+        vesc_telemetry.rpm = values.rpm;
+        changed |= TELEMETRY_RPM;
     }
 
 #if defined(ENABLE_VOLTAGE_MONITORING)
-    if (values.input_voltage != comm_get_values_setup_selective.input_voltage)
+    if (telemetry_changed(values.input_voltage, vesc_telemetry.input_voltage,
+                          TELEMETRY_VOLTAGE_DEADBAND))
     {
-        event_data_t data = {0};
-        data.voltage = values.input_voltage;
-        event_queue_push(EVENT_VOLTAGE_CHANGED, &data);
-
-        comm_get_values_setup_selective.input_voltage = values.input_voltage;
+        vesc_telemetry.input_voltage = values.input_voltage;
+        changed |= TELEMETRY_INPUT_VOLTAGE;
     }
 #endif
 
-    if (values.battery_level != comm_get_values_setup_selective.battery_level)
+    if (telemetry_changed(values.battery_level, vesc_telemetry.battery_level,
+                          TELEMETRY_BATTERY_DEADBAND))
     {
-        event_data_t data = {0};
-        data.battery_level = values.battery_level;
-        event_queue_push(EVENT_BATTERY_LEVEL_CHANGED, &data);
-
-        comm_get_values_setup_selective.battery_level = values.battery_level;
+        vesc_telemetry.battery_level = values.battery_level;
+        changed |= TELEMETRY_BATTERY_LEVEL;
     }
 
-    /*
-     * Handle fault changes.
-     */
-    if (values.fault != comm_get_values_setup_selective.fault)
+    if (values.fault != vesc_telemetry.fault)
     {
-        event_data_t data = {0};
-        data.vesc_fault = values.fault;
-        event_queue_push(EVENT_VESC_FAULT_CHANGED, &data);
-        comm_get_values_setup_selective.fault = values.fault;
+        vesc_telemetry.fault = values.fault;
+        changed |= TELEMETRY_FAULT;
     }
+
+    vesc_telemetry.sequence++;
+    return changed;
 }
 
 /**
@@ -432,105 +483,152 @@ void process_comm_get_values_setup_selective(const uint8_t *payload, uint8_t pac
  * @param payload The payload of the packet. The first byte of the payload is
  *                the command ID.
  * @param packet_length The length of the packet, including the command ID.
+ * @return The mask of telemetry fields that changed
  */
-void process_packet(uint8_t *payload, uint8_t packet_length)
+telemetry_fields_t process_packet(uint8_t *payload, uint8_t packet_length)
 {
+    telemetry_fields_t changed = TELEMETRY_NONE;
+
     // The first time we recieve a valid packet from the VESC, we know it is
     // alive
     if (vesc_alive == false)
     {
         event_queue_push(EVENT_VESC_ALIVE, NULL);
         vesc_alive = true;
+
+        // If we were probing after a timeout, go back to normal polling
+        if (vesc_serial_probe_interval != 0U)
+        {
+            vesc_serial_probe_interval = 0U;
+            vesc_serial_tx_timerid =
+                set_timer(POLLING_INTERVAL_MS, TIMER_CALLBACK_NAME(vesc_serial, tx), true);
+        }
+
+        // The telemetry is live again
+        if (vesc_telemetry.stale)
+        {
+            vesc_telemetry.stale = false;
+            changed |= TELEMETRY_STALE;
+        }
     }
 
     // First byte of payload is the command ID
     switch (payload[0])
     {
     case COMM_GET_VALUES_SETUP_SELECTIVE:
-        process_comm_get_values_setup_selective(payload, packet_length);
+        changed |= process_comm_get_values_setup_selective(payload, packet_length);
         break;
 #ifdef ENABLE_IMU_EVENTS
     case COMM_GET_IMU_DATA:
-        process_comm_get_imu_data(payload, packet_length);
+        changed |= process_comm_get_imu_data(payload, packet_length);
         break;
 #endif
     default:
         // Unknown command
         break;
     }
+
+    return changed;
 }
 
 /**
- * @brief Handles the reception of VESC serial data
+ * @brief Reads the next valid packet from the RX buffer
  *
- * This event handler processes incoming serial data from the VESC. It
- * searches for the start byte in the data stream, extracts the packet
- * length, payload, CRC, and end byte. If a valid packet is found, with
- * the correct CRC and end byte, the packet is processed by calling
- * process_packet().
+ * Searches for the start byte in the data stream, then extracts the packet
+ * length, payload, CRC, and end byte. Packets with a bad CRC or end byte are
+ * skipped.
+ *
+ * @param payload Buffer of at least MAX_PACKET_LENGTH bytes for the payload
+ * @param packet_length Receives the length of the payload
+ * @return LCM_SUCCESS if a valid packet was read, LCM_QUEUE_EMPTY if the
+ *         buffer ran out of data
  */
-EVENT_HANDLER(vesc_serial, rx)
+static lcm_status_t read_packet(uint8_t *payload, uint8_t *packet_length)
 {
     uint8_t byte = 0;
     uint16_t crc = 0;
-    uint8_t packet_length = 0;
-
-    // Initialization should not be necessary, since we will immediately
-    // overwrite the buffer, but MISRA requires it
-    uint8_t payload[MAX_PACKET_LENGTH] = {0};
-
-    // Reset the outstanding packet count
-    clear_outstanding_packets();
 
     // Search for start byte (or end of data)
-    while (byte != START_BYTE && ring_buffer_pop((ring_buffer_t *)&vesc_serial_rx_buffer, &byte))
+    while (ring_buffer_pop((ring_buffer_t *)&vesc_serial_rx_buffer, &byte))
     {
         // If we found the start byte, read the rest of the packet
         if (byte == START_BYTE)
         {
-            if (!ring_buffer_pop((ring_buffer_t *)&vesc_serial_rx_buffer, &packet_length) ||
-                packet_length > MAX_PACKET_LENGTH)
+            if (!ring_buffer_pop((ring_buffer_t *)&vesc_serial_rx_buffer, packet_length) ||
+                *packet_length > MAX_PACKET_LENGTH)
             {
-                return;
+                return LCM_QUEUE_EMPTY;
             }
 
-            for (uint8_t i = 0; i < packet_length; i++)
+            for (uint8_t i = 0; i < *packet_length; i++)
             {
                 if (!ring_buffer_pop((ring_buffer_t *)&vesc_serial_rx_buffer, &payload[i]))
                 {
-                    return;
+                    return LCM_QUEUE_EMPTY;
                 }
             }
 
             // Next two bytes should be the CRC
             if (!ring_buffer_pop((ring_buffer_t *)&vesc_serial_rx_buffer, &byte))
             {
-                return;
+                return LCM_QUEUE_EMPTY;
             }
             crc = byte << 8;
             if (!ring_buffer_pop((ring_buffer_t *)&vesc_serial_rx_buffer, &byte))
             {
-                return;
+                return LCM_QUEUE_EMPTY;
             }
             crc |= byte;
 
             // Last byte should be the end
             if (!ring_buffer_pop((ring_buffer_t *)&vesc_serial_rx_buffer, &byte))
             {
-                return;
+                return LCM_QUEUE_EMPTY;
             }
 
-            if (byte == END_BYTE)
+            // Check the end byte and CRC
+            if ((byte == END_BYTE) && (crc16_ccitt(payload, *packet_length) == crc))
             {
-                // Check CRC
-                if (crc16_ccitt(payload, packet_length) == crc)
-                {
-                    // Packet is valid
-                    process_packet(payload, packet_length);
-                }
+                // Packet is valid
+                return LCM_SUCCESS;
             }
         }
     }
+
+    return LCM_QUEUE_EMPTY;
+}
+
+/**
+ * @brief Handles the reception of VESC serial data
+ *
+ * This event handler processes every valid packet waiting in the RX buffer.
+ * The telemetry snapshot is updated as each packet is decoded, and a single
+ * EVENT_TELEMETRY_UPDATED is raised afterwards with the mask of all the
+ * fields that changed.
+ */
+EVENT_HANDLER(vesc_serial, rx)
+{
+    uint8_t packet_length = 0;
+    telemetry_fields_t changed = TELEMETRY_NONE;
+
+    // Initialization should not be necessary, since we will immediately
+    // overwrite the buffer, but MISRA requires it
+    uint8_t payload[MAX_PACKET_LENGTH] = {0};
+
+    // Reset the outstanding packet count
+    clear_outstanding_packets();
+
+    while (read_packet(payload, &packet_length) == LCM_SUCCESS)
+    {
+        changed |= process_packet(payload, packet_length);
+    }
+
+    if (changed != TELEMETRY_NONE)
+    {
+        event_data_t telemetry_data = {0};
+        telemetry_data.telemetry_changed = changed;
+        event_queue_push(EVENT_TELEMETRY_UPDATED, &telemetry_data);
+    }
 }
 
 /**
@@ -545,6 +643,12 @@ EVENT_HANDLER(vesc_serial, rx)
  */
 EVENT_HANDLER(vesc_serial, board_mode_change)
 {
+#ifdef ENABLE_IMU_EVENTS
+    // Only ask for IMU data if someone needs it in this mode
+    vesc_serial_imu_needed =
+        (vesc_serial_imu_demand & BOARD_MODE_MASK(data->board_mode.mode)) != 0U;
+#endif
+
     switch (data->board_mode.mode)
     {
     // modes where we want to poll the VESC
@@ -562,6 +666,7 @@ EVENT_HANDLER(vesc_serial, board_mode_change)
     // modes where we don't want to poll the VESC
     default:
         vesc_alive = false;
+        vesc_serial_probe_interval = 0U;
         if (vesc_serial_tx_timerid != INVALID_TIMER_ID && is_timer_active(vesc_serial_tx_timerid))
         {
             cancel_timer(vesc_serial_tx_timerid);
@@ -577,7 +682,8 @@ EVENT_HANDLER(vesc_serial, board_mode_change)
  * This function is called by the timer subsystem when the VESC serial
  * communication timer expires. It sends a packet to the VESC to poll
  * for data. The packet is hardcoded so that the timer callback is
- * as lightweight as possible.
+ * as lightweight as possible. The IMU request is only appended when some
+ * module needs IMU data in the current board mode.
  */
 TIMER_CALLBACK(vesc_serial, tx)
 {
@@ -609,17 +715,20 @@ TIMER_CALLBACK(vesc_serial, tx)
      * bytes 15-16 precomputed crc-16-ccitt (0x1afe)
      * byte 17: end byte (0x03)
      */
+#define VALUES_BYTE_LENGTH 10U
 #ifdef ENABLE_IMU_EVENTS
 #define BYTE_LENGTH 18U
     uint8_t buffer[BYTE_LENGTH] = {
         0x02, 0x05, 0x33, 0x00, 0x01, 0x01, 0xb0, 0x41, 0xe6, 0x03,
         0x02, 0x03, 0x41, 0x00, 0x03, 0x1a, 0xfe, 0x03
     };
+    uint16_t length = vesc_serial_imu_needed ? BYTE_LENGTH : VALUES_BYTE_LENGTH;
 #else
 #define BYTE_LENGTH 10U
     uint8_t buffer[BYTE_LENGTH] = {
         0x02, 0x05, 0x33, 0x00, 0x01, 0x01, 0xb0, 0x41, 0xe6, 0x03
     };
+    uint16_t length = BYTE_LENGTH;
 #endif
 
     if (vesc_alive == true)
@@ -632,85 +741,45 @@ TIMER_CALLBACK(vesc_serial, tx)
         // WS2812 LED updates should be disabled.
         if (vesc_serial_outstaning_packet_count++ >= MAX_OUTSTANDING_PACKETS)
         {
-            // Too many outstanding packets, trigger a fault
+            // Too many outstanding packets, trigger a fault and start
+            // probing to find the VESC again
             fault(EMERGENCY_FAULT_VESC_COMM_TIMEOUT);
             vesc_alive = false;
             clear_outstanding_packets();
+            start_probing();
         }
     }
-    vesc_serial_hw_send(buffer, BYTE_LENGTH);
-}
-
-/**
- * @brief Returns the current duty cycle of the VESC
- *
- * @return The current duty cycle of the VESC
- */
-float32_t vesc_serial_get_duty_cycle(void)
-{
-    return comm_get_values_setup_selective.duty_cycle;
-}
-
-/**
- * @brief Returns the current RPM of the VESC
- *
- * @return The current RPM of the VESC
- */
-int32_t vesc_serial_get_rpm(void)
-{
-    return comm_get_values_setup_selective.rpm;
-}
-
-#if defined(ENABLE_VOLTAGE_MONITORING)
-/**
- * @brief Returns the current input voltage of the VESC
- *
- * @return The current input voltage of the VESC
- */
-float32_t vesc_serial_get_input_voltage(void)
-{
-    return comm_get_values_setup_selective.input_voltage;
+    else if (vesc_serial_probe_interval != 0U)
+    {
+        backoff_probing();
+    }
+    // No else needed, waiting for the VESC to boot
+    vesc_serial_hw_send(buffer, length);
 }
-#endif
 
 /**
- * @brief Returns the current battery level of the VESC
+ * @brief Returns the current telemetry snapshot
  *
- * @return The current battery level of the VESC
+ * @return A pointer to the telemetry snapshot
  */
-float32_t vesc_serial_get_battery_level(void)
+const vesc_telemetry_t *vesc_serial_get_telemetry(void)
 {
-    return comm_get_values_setup_selective.battery_level;
+    return &vesc_telemetry;
 }
 
 /**
- * @brief Returns the current fault of the VESC
- *
- * @return The current fault of the VESC
+ * @brief Declares which telemetry fields a module needs in which board modes
  */
-uint8_t vesc_serial_get_fault(void)
+void vesc_serial_declare_demand(telemetry_fields_t fields, board_mode_mask_t modes)
 {
-    return comm_get_values_setup_selective.fault;
-}
-
 #ifdef ENABLE_IMU_EVENTS
-/**
- * @brief Returns the current pitch of the VESC IMU in degrees
- *
- * @return The current pitch of the VESC IMU
- */
-float32_t vesc_serial_get_imu_pitch(void)
-{
-    return comm_get_imu_data.pitch;
-}
-
-/**
- * @brief Returns the current roll of the VESC IMU in degrees
- *
- * @return The current roll of the VESC IMU
- */
-float32_t vesc_serial_get_imu_roll(void)
-{
-    return comm_get_imu_data.roll;
+    if ((fields & (TELEMETRY_IMU_PITCH | TELEMETRY_IMU_ROLL)) != 0U)
+    {
+        vesc_serial_imu_demand |= modes;
+    }
+#else
+    // Without the IMU there is nothing optional to poll
+    (void)fields;
+    (void)modes;
+#endif
 }
-#endif
\ No newline at end of file
@@ -17,7 +17,9 @@
  ; with ALCM. If not, see <https://www.gnu.org/licenses/>.
  ;
     AREA WS2812, CODE, READONLY
-    EXPORT ws2812_send_buffer
+    EXPORT ws2812_send_scaled
+    EXPORT ws2812_send_dithered
+    EXPORT ws2812_latch
 
 T0H EQU 1
 T1H EQU 3
@@ -28,78 +30,261 @@ PIN_RESET EQU (1 << (4 + 16))
 GPIOD_BSRR EQU 0x48000C18
 
 
-; This function is used to send WS2812 buffer. It is written in
+; These functions are used to send WS2812 buffers. They are written in
 ; assembly because of the tight timing requirements of the WS2812
 ; protocol.
 ;
 ; This prevents compiler optimization changes from causing timing
 ; issues by carrying out the timing critical code in assembly.
 ;
-; R0 = uint8_t* buffer
+; Global brightness is applied to each byte as it is loaded, between
+; bytes where the line is low and the timing is relaxed, so the caller
+; does not need to make a scaled copy of the buffer first.
+;
+; Interrupts are disabled by these functions only while a LED (3 or 4
+; bytes, passed in as the channel count) is being sent. Between LEDs they
+; are briefly enabled again so pending interrupts (USART RX, SysTick) get
+; serviced; the line is held low while they run, which the strip only
+; treats as a latch after about 50 us. Interrupt handlers must therefore
+; stay short.
+;
+; The senders do not latch, so chained strips with a different number of
+; channels per LED can be sent one after the other. ws2812_latch is called
+; once the whole frame is out.
+
+
+; Sends a buffer scaled by a global brightness.
+;
+; R0 = const uint8_t* buffer
 ; R1 = uint32_t length
+; R2 = uint32_t scale (Q8, 256 = full brightness)
+; R3 = uint32_t channels (bytes per LED, not 0)
 ;
 ; Returns nothing
-ws2812_send_buffer
+ws2812_send_scaled
     PUSH {R4-R7, LR}
+    MOV R4, R8
+    PUSH {R4}
 
     CMP R0, #0                    ; Check if buffer is NULL
-    BEQ end_function              ; If it is, return
+    BEQ scaled_end_function       ; If it is, return
 
     CMP R1, #0                    ; Check if length is 0
-    BEQ end_function              ; If it is, return
+    BEQ scaled_end_function       ; If it is, return
 
     ; Pre-load constants
     LDR R6, =GPIOD_BSRR
+    MOVS R5, R2
+    MOV R8, R3
 
-next_byte
+    ; Setup LED channel counter, interrupts off while sending a LED
+    MOV R12, R3
+    CPSID i
+
+scaled_next_byte
     LDRB R2, [R0]
     ADDS R0, R0, #1
 
+    ; Scale by global brightness
+    MULS R2, R5, R2
+    LSRS R2, R2, #8
+
     ; Shift up to the MSB
     LSLS R2, R2, #24
 
     ; Setup 8-bit loop counter
     MOVS R3, #8
 
-next_bit
+scaled_next_bit
     LSLS R2, R2, #1
-    BCC bit_0
-    B bit_1
+    BCC scaled_bit_0
+    B scaled_bit_1
 
-bit_0
+scaled_bit_0
 	MOVS R4, #T0H
-    B send_bit
+    B scaled_send_bit
 
-bit_1
+scaled_bit_1
 	MOVS R4, #T1H
-    B send_bit
+    B scaled_send_bit
 
-send_bit
+scaled_send_bit
 	MOVS R7, #PIN_SET
     STR R7, [R6]
 
-high_delay
+scaled_high_delay
     SUBS R4, R4, #1
-    BNE high_delay
+    BNE scaled_high_delay
 
     LDR R7, =PIN_RESET
     STR R7, [R6]
 
     ; Next bit in byte
     SUBS R3, R3, #1
-    BNE next_bit
+    BNE scaled_next_bit
 
     ; Next byte in buffer
     SUBS R1, R1, #1
-    BNE next_byte
+    BEQ scaled_latch
 
-    ; 50 us delay required for Treset
-	LDR R4, =TRESET
-t_reset
+    ; Next byte in LED
+    MOV R7, R12
+    SUBS R7, R7, #1
+    BNE scaled_same_led
+
+    ; LED done, let pending interrupts run before the next one
+    CPSIE i
+    ISB
+    CPSID i
+    MOV R7, R8
+
+scaled_same_led
+    MOV R12, R7
+    B scaled_next_byte
+
+scaled_latch
+    CPSIE i
+
+scaled_end_function
+    POP {R4}
+    MOV R8, R4
+    POP {R4-R7, PC}
+
+
+; Sends a buffer through a Q8.8 lookup table (e.g. gamma correction),
+; scaled by a global brightness, with the fractional part of each byte
+; carried over to the next frame (temporal dithering). For each byte:
+;
+;   level = ((table[buffer[i]] * scale) >> 8) + residue[i]
+;   send (level >> 8), residue[i] = level & 0xFF
+;
+; R0 = const uint8_t* buffer
+; R1 = uint32_t length
+; R2 = uint32_t scale (Q8, 256 = full brightness)
+; R3 = const uint16_t* table (256 entries, Q8.8)
+; [SP] = uint8_t* residue (length entries)
+; [SP + 4] = uint32_t channels (bytes per LED, not 0)
+;
+; Returns nothing
+ws2812_send_dithered
+    PUSH {R4-R7, LR}
+    MOV R4, R8
+    MOV R5, R9
+    MOV R6, R10
+    PUSH {R4-R6}
+
+    CMP R0, #0                    ; Check if buffer is NULL
+    BEQ dithered_end_function     ; If it is, return
+
+    CMP R1, #0                    ; Check if length is 0
+    BEQ dithered_end_function     ; If it is, return
+
+    ; Pre-load constants, the residue pointer and channel count are the
+    ; 5th and 6th arguments and sit above the 8 registers pushed so far
+    LDR R4, [SP, #32]
+    MOV R9, R4
+    LDR R7, [SP, #36]
+    MOV R10, R7
+    MOV R8, R2
+    MOVS R5, R3
+    LDR R6, =GPIOD_BSRR
+
+    ; Setup LED channel counter, interrupts off while sending a LED
+    MOV R12, R7
+    CPSID i
+
+dithered_next_byte
+    LDRB R2, [R0]
+    ADDS R0, R0, #1
+
+    ; Look up the Q8.8 level and scale by global brightness
+    LSLS R2, R2, #1
+    LDRH R2, [R5, R2]
+    MOV R3, R8
+    MULS R2, R3, R2
+    LSRS R2, R2, #8
+
+    ; Add the fraction left over from the last frame and keep the new one
+    MOV R7, R9
+    LDRB R3, [R7]
+    ADDS R2, R2, R3
+    STRB R2, [R7]
+    ADDS R7, R7, #1
+    MOV R9, R7
+
+    ; Shift the integer part up to the MSB
+    LSRS R2, R2, #8
+    LSLS R2, R2, #24
+
+    ; Setup 8-bit loop counter
+    MOVS R3, #8
+
+dithered_next_bit
+    LSLS R2, R2, #1
+    BCC dithered_bit_0
+    B dithered_bit_1
+
+dithered_bit_0
+	MOVS R4, #T0H
+    B dithered_send_bit
+
+dithered_bit_1
+	MOVS R4, #T1H
+    B dithered_send_bit
+
+dithered_send_bit
+	MOVS R7, #PIN_SET
+    STR R7, [R6]
+
+dithered_high_delay
     SUBS R4, R4, #1
-    BNE t_reset
+    BNE dithered_high_delay
 
-end_function
-	NOP
+    LDR R7, =PIN_RESET
+    STR R7, [R6]
+
+    ; Next bit in byte
+    SUBS R3, R3, #1
+    BNE dithered_next_bit
+
+    ; Next byte in buffer
+    SUBS R1, R1, #1
+    BEQ dithered_latch
+
+    ; Next byte in LED
+    MOV R7, R12
+    SUBS R7, R7, #1
+    BNE dithered_same_led
+
+    ; LED done, let pending interrupts run before the next one
+    CPSIE i
+    ISB
+    CPSID i
+    MOV R7, R10
+
+dithered_same_led
+    MOV R12, R7
+    B dithered_next_byte
+
+dithered_latch
+    CPSIE i
+
+dithered_end_function
+    POP {R4-R6}
+    MOV R8, R4
+    MOV R9, R5
+    MOV R10, R6
     POP {R4-R7, PC}
+
+
+; Holds the line low for Treset so the strip latches the data sent.
+;
+; Returns nothing
+ws2812_latch
+    ; 50 us delay required for Treset
+	LDR R0, =TRESET
+latch_t_reset
+    SUBS R0, R0, #1
+    BNE latch_t_reset
+    BX LR
     END
\ No newline at end of file
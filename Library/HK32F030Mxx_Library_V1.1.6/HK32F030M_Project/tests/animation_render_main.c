@@ -0,0 +1,532 @@
+/*
+ * Copyright (c) 2024-2025, Mitchell White <mitchell.n.white@gmail.com>
+ *
+ * This file is part of Advanced LCM (ALCM) project.
+ *
+ * ALCM is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * ALCM is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with ALCM. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file animation_render_main.c
+ * @brief Offline renderer and frame cost benchmark for the status LED animations
+ * @details Links the real animations, function generator, settings and status
+ *          LED modules against deterministic stubs, so every animation option
+ *          can be rendered and timed without hardware. The timer is a virtual
+ *          millisecond clock, and each frame is what the strip would be sent
+ *          (in RGB order, before the channel order is applied).
+ *
+ *          Usage: animation_render [-n frames] [-m level] [-r repeats]
+ *                                  [-f csv|ppm] [-o dir] [-c dir]
+ *
+ *          -n  Frames to render for each option (default 160, 4 seconds).
+ *          -m  Modulation level fed to animations that follow the telemetry.
+ *          -r  Times each option is replayed to time it, 0 to skip timing.
+ *          -f  Write each option as CSV (frame,led,r,g,b) or a PPM strip with
+ *              one row per frame.
+ *          -o  Directory to write the frames to.
+ *          -c  Directory of CSV frames to compare against, for golden frame
+ *              regression checks. Exits with an error on any difference.
+ *
+ *          The reported time is host time per frame, useful to compare one
+ *          engine against another. For instruction counts run the tool under
+ *          valgrind --tool=callgrind, and for target cycles use
+ *          ENABLE_STATUS_LEDS_BENCHMARK.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "animations.h"
+#include "board_mode.h"
+#include "eeprom.h"
+#include "event_queue.h"
+#include "footpads.h"
+#include "settings.h"
+#include "status_leds.h"
+#include "status_leds_hw.h"
+#include "timer.h"
+#include "vesc_serial.h"
+
+#define RENDER_FRAME_MS 25U       // Virtual time between frames (ms)
+#define RENDER_DEFAULT_FRAMES 160U
+#define RENDER_DEFAULT_REPEATS 50U
+#define RENDER_MAX_TIMERS 8U
+#define RENDER_PATH_LENGTH 512U
+
+typedef enum
+{
+    RENDER_FORMAT_CSV,
+    RENDER_FORMAT_PPM
+} render_format_t;
+
+typedef struct
+{
+    uint32_t timeout;           // Period of the timer (ms)
+    uint32_t due;               // Virtual time the timer fires next (ms)
+    void (*callback)(uint32_t); // Function called when the timer fires
+    bool_t repeat;              // True if the timer restarts after firing
+    bool_t active;              // True while the timer is running
+} render_timer_t;
+
+// Virtual clock and timers
+static render_timer_t render_timers[RENDER_MAX_TIMERS];
+static uint32_t render_now = 0U;
+
+// Last frame sent to the strip
+static status_leds_color_t render_shown[STATUS_LEDS_MAX_COUNT];
+
+// Stub state
+static uint32_t render_faults = 0U;
+static vesc_telemetry_t render_telemetry = {0};
+
+/*
+ * Stubs for the modules the status LEDs depend on
+ */
+lcm_status_t subscribe_event(event_type_t event,
+                             void (*callback)(event_type_t event, const event_data_t *data))
+{
+    (void)event;
+    (void)callback;
+    return LCM_SUCCESS;
+}
+
+lcm_status_t event_queue_push(event_type_t event, const event_data_t *data)
+{
+    (void)event;
+    (void)data;
+    return LCM_SUCCESS;
+}
+
+void fault(emergency_fault_t fault)
+{
+    fprintf(stderr, "fault %d at %lu ms\n", (int)fault, (unsigned long)render_now);
+    render_faults++;
+}
+
+timer_id_t set_timer(uint32_t timeout, void (*callback)(uint32_t), bool_t repeat)
+{
+    timer_id_t timer_id = INVALID_TIMER_ID;
+
+    // Like timer.c, a timer that is already set for the callback is updated
+    // rather than set a second time
+    for (uint8_t i = 0U; i < RENDER_MAX_TIMERS; i++)
+    {
+        if (render_timers[i].active && (render_timers[i].callback == callback))
+        {
+            timer_id = (timer_id_t)(i + 1U);
+            break;
+        }
+    }
+
+    for (uint8_t i = 0U; (timer_id == INVALID_TIMER_ID) && (i < RENDER_MAX_TIMERS); i++)
+    {
+        if (!render_timers[i].active)
+        {
+            timer_id = (timer_id_t)(i + 1U);
+        }
+    }
+
+    if (timer_id != INVALID_TIMER_ID)
+    {
+        render_timer_t *timer = &render_timers[timer_id - 1U];
+
+        timer->timeout = timeout;
+        timer->due = render_now + timeout;
+        timer->callback = callback;
+        timer->repeat = repeat;
+        timer->active = true;
+    }
+
+    return timer_id;
+}
+
+lcm_status_t cancel_timer(timer_id_t timer_id)
+{
+    lcm_status_t status = LCM_ERROR;
+
+    if ((timer_id > 0U) && (timer_id <= RENDER_MAX_TIMERS))
+    {
+        render_timers[timer_id - 1U].active = false;
+        status = LCM_SUCCESS;
+    }
+
+    return status;
+}
+
+bool_t is_timer_active(timer_id_t timer_id)
+{
+    return (timer_id > 0U) && (timer_id <= RENDER_MAX_TIMERS) &&
+           render_timers[timer_id - 1U].active;
+}
+
+void eeprom_read(uint16_t addr, uint8_t *data, uint16_t len)
+{
+    // Blank EEPROM, the settings fall back to their defaults
+    (void)addr;
+    memset(data, 0xFF, len);
+}
+
+void eeprom_write(uint16_t addr, uint8_t *data, uint16_t len)
+{
+    (void)addr;
+    (void)data;
+    (void)len;
+}
+
+board_mode_t board_mode_get(void)
+{
+    return BOARD_MODE_IDLE;
+}
+
+board_submode_t board_submode_get(void)
+{
+    return BOARD_SUBMODE_IDLE_DEFAULT;
+}
+
+footpads_state_t footpads_get_state(void)
+{
+    return NONE_FOOTPAD;
+}
+
+const vesc_telemetry_t *vesc_serial_get_telemetry(void)
+{
+    return &render_telemetry;
+}
+
+void vesc_serial_declare_demand(telemetry_fields_t fields, board_mode_mask_t modes)
+{
+    (void)fields;
+    (void)modes;
+}
+
+void status_leds_hw_init(void)
+{
+}
+
+void status_leds_hw_refresh(const status_leds_color_t *frame)
+{
+    memcpy(render_shown, frame, sizeof(render_shown));
+}
+
+bool_t status_leds_hw_busy(void)
+{
+    // Frames are sent immediately
+    return false;
+}
+
+void status_leds_hw_set_strips(const status_leds_strip_t *strips)
+{
+    (void)strips;
+}
+
+void status_leds_hw_set_brightness(float32_t brightness)
+{
+    (void)brightness;
+}
+
+void status_leds_hw_enable(bool_t enable)
+{
+    (void)enable;
+}
+
+/*
+ * Renderer
+ */
+
+/**
+ * @brief Advances the virtual clock by one frame, firing the timers that come
+ * due and sending the resulting frame.
+ */
+static void render_step(void)
+{
+    for (uint32_t ms = 0U; ms < RENDER_FRAME_MS; ms++)
+    {
+        render_now++;
+        for (uint8_t i = 0U; i < RENDER_MAX_TIMERS; i++)
+        {
+            render_timer_t *timer = &render_timers[i];
+
+            if (timer->active && (timer->due == render_now))
+            {
+                timer->active = timer->repeat;
+                timer->due = render_now + timer->timeout;
+                timer->callback(render_now);
+            }
+        }
+    }
+
+    status_leds_flush();
+}
+
+/**
+ * @brief Starts an animation option from a blank strip and a stopped clock.
+ */
+static void render_start(animation_option_t option, uint8_t level)
+{
+    memset(render_timers, 0, sizeof(render_timers));
+    memset(render_shown, 0, sizeof(render_shown));
+    render_now = 0U;
+
+    // Initializing drops the previous animation and sends a black frame
+    (void)status_leds_init();
+    status_leds_flush();
+
+    (void)status_leds_start_animation_option(option);
+    animation_set_modulation(level);
+}
+
+/**
+ * @brief Renders the frames of an animation option.
+ *
+ * @param frames Where to store the frames, frame_count * STATUS_LEDS_MAX_COUNT
+ * colors.
+ */
+static void render_option(animation_option_t option, uint8_t level, uint32_t frame_count,
+                          status_leds_color_t *frames)
+{
+    render_start(option, level);
+
+    for (uint32_t frame = 0U; frame < frame_count; frame++)
+    {
+        render_step();
+        memcpy(&frames[frame * STATUS_LEDS_MAX_COUNT], render_shown, sizeof(render_shown));
+    }
+}
+
+/**
+ * @brief Returns the host time taken by a frame of an animation option (us).
+ */
+static double render_time(animation_option_t option, uint8_t level, uint32_t frame_count,
+                          uint32_t repeats)
+{
+    clock_t elapsed = 0;
+
+    for (uint32_t repeat = 0U; repeat < repeats; repeat++)
+    {
+        clock_t start = 0;
+
+        render_start(option, level);
+        start = clock();
+        for (uint32_t frame = 0U; frame < frame_count; frame++)
+        {
+            render_step();
+        }
+        elapsed += clock() - start;
+    }
+
+    return ((double)elapsed * 1000000.0) / CLOCKS_PER_SEC / ((double)frame_count * repeats);
+}
+
+/**
+ * @brief Writes the frames of an option to a file.
+ *
+ * @return True if the file was written.
+ */
+static bool_t render_write(const char *path, render_format_t format, uint32_t frame_count,
+                           uint8_t led_count, const status_leds_color_t *frames)
+{
+    FILE *file = fopen(path, (format == RENDER_FORMAT_PPM) ? "wb" : "w");
+    bool_t written = false;
+
+    if (file != NULL)
+    {
+        if (format == RENDER_FORMAT_PPM)
+        {
+            fprintf(file, "P6\n%u %lu\n255\n", led_count, (unsigned long)frame_count);
+        }
+        else
+        {
+            fprintf(file, "frame,led,r,g,b\n");
+        }
+
+        for (uint32_t frame = 0U; frame < frame_count; frame++)
+        {
+            for (uint8_t led = 0U; led < led_count; led++)
+            {
+                const status_leds_color_t *color = &frames[frame * STATUS_LEDS_MAX_COUNT + led];
+
+                if (format == RENDER_FORMAT_PPM)
+                {
+                    fwrite(color, sizeof(*color), 1U, file);
+                }
+                else
+                {
+                    fprintf(file, "%lu,%u,%u,%u,%u\n", (unsigned long)frame, led, color->r,
+                            color->g, color->b);
+                }
+            }
+        }
+
+        written = (ferror(file) == 0);
+        written = (fclose(file) == 0) && written;
+    }
+
+    return written;
+}
+
+/**
+ * @brief Compares the frames of an option against a CSV file written earlier.
+ *
+ * @return Number of LEDs that differ, or that are missing from the file.
+ */
+static uint32_t render_compare(const char *path, uint32_t frame_count, uint8_t led_count,
+                               const status_leds_color_t *frames)
+{
+    FILE *file = fopen(path, "r");
+    uint32_t mismatches = frame_count * led_count;
+
+    if (file != NULL)
+    {
+        unsigned long frame = 0UL;
+        unsigned int led = 0U, r = 0U, g = 0U, b = 0U;
+
+        mismatches = 0U;
+        (void)fscanf(file, "%*[^\n]\n"); // Header
+        for (uint32_t i = 0U; i < frame_count * led_count; i++)
+        {
+            const status_leds_color_t *color =
+                &frames[(i / led_count) * STATUS_LEDS_MAX_COUNT + (i % led_count)];
+
+            if ((fscanf(file, "%lu,%u,%u,%u,%u", &frame, &led, &r, &g, &b) != 5) ||
+                (frame != i / led_count) || (led != i % led_count) || (r != color->r) ||
+                (g != color->g) || (b != color->b))
+            {
+                if (mismatches == 0U)
+                {
+                    fprintf(stderr, "%s: first difference at frame %lu led %u\n", path,
+                            (unsigned long)(i / led_count), (unsigned int)(i % led_count));
+                }
+                mismatches++;
+            }
+        }
+
+        fclose(file);
+    }
+    else
+    {
+        fprintf(stderr, "%s: not found\n", path);
+    }
+
+    return mismatches;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t frame_count = RENDER_DEFAULT_FRAMES;
+    uint32_t repeats = RENDER_DEFAULT_REPEATS;
+    uint8_t level = 0U;
+    render_format_t format = RENDER_FORMAT_CSV;
+    const char *output_dir = NULL;
+    const char *golden_dir = NULL;
+    status_leds_color_t *frames = NULL;
+    uint32_t mismatches = 0U;
+    uint8_t led_count = 0U;
+    int result = EXIT_SUCCESS;
+
+    for (int i = 1; (i < argc) && (result == EXIT_SUCCESS); i += 2)
+    {
+        if ((i + 1) >= argc)
+        {
+            fprintf(stderr, "missing value for %s\n", argv[i]);
+            result = EXIT_FAILURE;
+        }
+        else if (strcmp(argv[i], "-n") == 0)
+        {
+            frame_count = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-m") == 0)
+        {
+            level = (uint8_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-r") == 0)
+        {
+            repeats = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-f") == 0)
+        {
+            format = (strcmp(argv[i + 1], "ppm") == 0) ? RENDER_FORMAT_PPM : RENDER_FORMAT_CSV;
+        }
+        else if (strcmp(argv[i], "-o") == 0)
+        {
+            output_dir = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "-c") == 0)
+        {
+            golden_dir = argv[i + 1];
+        }
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            result = EXIT_FAILURE;
+        }
+    }
+
+    frames = calloc((size_t)frame_count * STATUS_LEDS_MAX_COUNT, sizeof(status_leds_color_t));
+    if ((frames == NULL) || (frame_count == 0U))
+    {
+        result = EXIT_FAILURE;
+    }
+
+    if (result == EXIT_SUCCESS)
+    {
+        (void)settings_init();
+        (void)status_leds_init();
+        led_count = status_leds_get_count();
+
+        printf("option  frames  leds  us/frame\n");
+        for (uint8_t option = 0U; option < ANIMATION_OPTION_COUNT; option++)
+        {
+            char path[RENDER_PATH_LENGTH];
+            double us_per_frame = 0.0;
+
+            render_option((animation_option_t)option, level, frame_count, frames);
+
+            if (output_dir != NULL)
+            {
+                snprintf(path, sizeof(path), "%s/animation_%02u.%s", output_dir, option,
+                         (format == RENDER_FORMAT_PPM) ? "ppm" : "csv");
+                if (!render_write(path, format, frame_count, led_count, frames))
+                {
+                    fprintf(stderr, "%s: could not be written\n", path);
+                    result = EXIT_FAILURE;
+                }
+            }
+
+            if (golden_dir != NULL)
+            {
+                snprintf(path, sizeof(path), "%s/animation_%02u.csv", golden_dir, option);
+                mismatches += render_compare(path, frame_count, led_count, frames);
+            }
+
+            if (repeats > 0U)
+            {
+                us_per_frame = render_time((animation_option_t)option, level, frame_count, repeats);
+            }
+            printf("%6u  %6lu  %4u  %8.3f\n", option, (unsigned long)frame_count, led_count,
+                   us_per_frame);
+        }
+    }
+
+    if ((mismatches > 0U) || (render_faults > 0U))
+    {
+        fprintf(stderr, "%lu differences, %lu faults\n", (unsigned long)mismatches,
+                (unsigned long)render_faults);
+        result = EXIT_FAILURE;
+    }
+
+    free(frames);
+
+    return result;
+}
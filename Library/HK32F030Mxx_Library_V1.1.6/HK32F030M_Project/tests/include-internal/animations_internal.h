@@ -0,0 +1,10 @@
+#ifndef ANIMATIONS_INTERNAL_H
+#define ANIMATIONS_INTERNAL_H
+
+#include "animations.h"
+
+// Normally private, but needed for testing
+uint16_t calculate_brightness(int32_t mu, uint32_t inv_sigma, uint8_t i);
+void hue_to_rgb(int32_t hue, status_leds_color_t *color);
+
+#endif /* ANIMATIONS_INTERNAL_H */
@@ -0,0 +1,11 @@
+#ifndef VESC_SERIAL_INTERNAL_H
+#define VESC_SERIAL_INTERNAL_H
+
+#include "vesc_serial.h"
+
+// Normally private, but needed for testing
+#ifdef ENABLE_IMU_EVENTS
+int16_t buffer_get_radians_as_centidegrees(const uint8_t *buffer);
+#endif
+
+#endif /* VESC_SERIAL_INTERNAL_H */
@@ -98,6 +98,23 @@ uint16_t fire_animation_setup(status_leds_color_t *buffer) {
     return mock_type(uint16_t);
 }
 
+void bar_fill(status_leds_color_t *buffer, int32_t level, const status_leds_color_t *color) {
+    check_expected(buffer);
+    check_expected(level);
+    check_expected_ptr(color);
+    function_called();
+}
+
+void animation_crossfade_start(uint8_t frames) {
+    check_expected(frames);
+    function_called();
+}
+
+uint8_t animation_crossfade_alpha(void) {
+    // The crossfade completes as soon as it is composed
+    return 0U;
+}
+
 void stop_animation(void) {
     function_called();
 }
@@ -110,6 +127,16 @@ void hsl_to_rgb(float h, float s, float l, status_leds_color_t *color) {
     function_called();
 }
 
+void animation_modulate(uint8_t targets) {
+    // Bindings only matter to the real animation engine
+    (void)targets;
+}
+
+void animation_set_modulation(uint8_t level) {
+    check_expected(level);
+    function_called();
+}
+
 uint16_t get_animation_id(void) {
     function_called();
     return mock_type(uint16_t);
@@ -39,7 +39,9 @@ typedef struct
 }
 subscriber_struct_t;
 
+#ifndef MAX_SUBSCRIPTIONS
 #define MAX_SUBSCRIPTIONS 32
+#endif
 
 // Mock subscription list
 static subscriber_struct_t subscriptions[MAX_SUBSCRIPTIONS];
@@ -130,4 +132,12 @@ int validate_board_mode_event_data(const uintmax_t data, const uintmax_t check_d
     assert_int_equal(received_data->board_mode.mode, expected_state->mode);
     assert_int_equal(received_data->board_mode.submode, expected_state->submode);
     return 1;
-}
\ No newline at end of file
+}
+
+int validate_telemetry_changed(const uintmax_t data, const uintmax_t check_data)
+{
+    const event_data_t *received_data = (const event_data_t *)(uintptr_t)data;
+
+    assert_int_equal(received_data->telemetry_changed, (telemetry_fields_t)check_data);
+    return 1;
+}
@@ -27,5 +27,6 @@ void event_queue_test_bad_event(event_type_t expected, event_type_t actual, cons
 // Validation functions
 int validate_footpads_state(const uintmax_t data, const uintmax_t check_data);
 int validate_board_mode_event_data(const uintmax_t data, const uintmax_t check_data);
+int validate_telemetry_changed(const uintmax_t data, const uintmax_t check_data);
 
 #endif
\ No newline at end of file
@@ -65,6 +65,15 @@ void headlights_hw_set_brightness(uint16_t brightness)
     check_expected(brightness);
 }
 
+/**
+ * @brief   Mock function to invert the brightness curve, which is linear here
+ * @param   duty    The duty cycle to convert
+ */
+uint16_t headlights_hw_lightness(uint16_t duty)
+{
+    return duty;
+}
+
 uint16_t headlights_hw_get_brightness(void)
 {
     return (uint16_t)mock();
@@ -25,6 +25,7 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <setjmp.h>
+#include <string.h>
 #include <cmocka.h>
 
 #include "settings.h"
@@ -44,6 +45,8 @@ lcm_status_t settings_init(void) {
     mock_settings.shutdown_animation = ANIMATION_OPTION_NONE;
     mock_settings.ride_animation = ANIMATION_OPTION_NONE;
     mock_settings.personal_color = 0.0f;
+    memset(mock_settings.status_leds_strips, 0, sizeof(mock_settings.status_leds_strips));
+    mock_settings.status_leds_strips[0].count = STATUS_LEDS_MAX_COUNT;
 
     return LCM_SUCCESS;
 }
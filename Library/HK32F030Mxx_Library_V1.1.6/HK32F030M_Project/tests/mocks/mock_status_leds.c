@@ -39,6 +39,10 @@ lcm_status_t status_leds_set_color(
     return mock_type(lcm_status_t);
 }
 
+uint8_t status_leds_get_count(void) {
+    return STATUS_LEDS_MAX_COUNT;
+}
+
 lcm_status_t status_leds_refresh(void) {
     function_called();
     return mock_type(lcm_status_t);
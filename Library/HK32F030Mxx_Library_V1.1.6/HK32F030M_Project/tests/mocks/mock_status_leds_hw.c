@@ -28,18 +28,28 @@ static const status_leds_color_t* mock_status_leds_hw_buffer = 0;
 /**
  * @brief   Mock function to initialize the status LEDs hardware module
  */
-void status_leds_hw_init(const status_leds_color_t* buffer)
+void status_leds_hw_init(void)
 {
-    mock_status_leds_hw_buffer = buffer;
-    check_expected_ptr(buffer);
     function_called();
 }
 
-void status_leds_hw_refresh()
+void status_leds_hw_refresh(const status_leds_color_t* frame)
 {
+    mock_status_leds_hw_buffer = frame;
     function_called();
 }
 
+void status_leds_hw_set_strips(const status_leds_strip_t* strips)
+{
+    (void)strips;
+}
+
+bool status_leds_hw_busy(void)
+{
+    // Frames are sent immediately
+    return false;
+}
+
 void status_leds_hw_set_brightness(float brightness)
 {
     check_expected(brightness);
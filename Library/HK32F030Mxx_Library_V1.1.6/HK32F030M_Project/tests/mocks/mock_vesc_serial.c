@@ -32,18 +32,11 @@ ring_buffer_t *vesc_serial_get_rx_buffer(void) {
     return (ring_buffer_t *)mock();
 }
 
-float vesc_serial_get_duty_cycle(void) {
-    return (float)mock();
+const vesc_telemetry_t *vesc_serial_get_telemetry(void) {
+    return (const vesc_telemetry_t *)mock();
 }
 
-int32_t vesc_serial_get_rpm(void) {
-    return (int32_t)mock();
+void vesc_serial_declare_demand(telemetry_fields_t fields, board_mode_mask_t modes) {
+    check_expected(fields);
+    check_expected(modes);
 }
-
-float vesc_serial_get_battery_level(void) {
-    return (float)mock();
-}
-
-uint8_t vesc_serial_get_fault(void) {
-    return (uint8_t)mock();
-}
\ No newline at end of file
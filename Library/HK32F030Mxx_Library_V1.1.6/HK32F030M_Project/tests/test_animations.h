@@ -24,7 +24,7 @@
 #include <stddef.h>
 
 #include "mock_timer.h"
-#include "animations.h"
+#include "animations_internal.h"
 
 #define NUM_LEDS 10
 
@@ -82,6 +82,300 @@ static void fill_test(void **state)
     }
 }
 
+/**
+ * @brief Reference e^(-x) from a Taylor series, accurate for 0 <= x < 8.
+ */
+static double reference_exp_neg(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+
+    for (uint8_t n = 1; n < 60; n++)
+    {
+        term *= x / n;
+        sum += term;
+    }
+
+    return 1.0 / sum;
+}
+
+/**
+ * @brief Test the fixed-point gaussian against the exact distribution.
+ *
+ * @param state Pointer to the test state.
+ */
+static void gaussian_test(void **state)
+{
+    (void)state; // Unused parameter
+
+    const float sigmas[] = {0.5f, SIGMA_DEFAULT, 1.0f, 2.0f};
+
+    for (uint8_t s = 0; s < sizeof(sigmas) / sizeof(sigmas[0]); s++)
+    {
+        float sigma = sigmas[s];
+        uint32_t inv_sigma = (uint32_t)(4096.0f / sigma + 0.5f);
+
+        // Sweep mu across the strip in 1/16 LED steps
+        for (int32_t mu = -3 * 256; mu <= 12 * 256; mu += 16)
+        {
+            for (uint8_t i = 0; i < NUM_LEDS; i++)
+            {
+                float distance = i - (mu / 256.0f);
+                float exponent = 0.5f * (distance * distance) / (sigma * sigma);
+                uint8_t actual = (uint8_t)((255 * calculate_brightness(mu, inv_sigma, i)) >> 15);
+
+                // Tails beyond 4 sigma are cut off
+                if (exponent >= 8.0f)
+                {
+                    assert_int_equal(actual, 0);
+                    continue;
+                }
+
+                uint8_t expected = (uint8_t)(255 * reference_exp_neg(exponent));
+
+                assert_in_range(actual, expected > 0 ? expected - 1 : 0, expected + 1);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Test that the integer hue wheel matches hsl_to_rgb exactly.
+ *
+ * @param state Pointer to the test state.
+ */
+static void hue_test(void **state)
+{
+    (void)state; // Unused parameter
+
+    // Sweep every step of the 1536 unit hue wheel
+    for (int32_t hue = 0; hue < 1536; hue++)
+    {
+        status_leds_color_t expected = {0};
+        status_leds_color_t actual = {0};
+
+        hsl_to_rgb(hue * 360.0f / 1536.0f, SATURATION_DEFAULT, LIGHTNESS_DEFAULT, &expected);
+        hue_to_rgb(hue, &actual);
+
+        assert_int_equal(actual.r, expected.r);
+        assert_int_equal(actual.g, expected.g);
+        assert_int_equal(actual.b, expected.b);
+    }
+}
+
+/**
+ * @brief Test a single step of the fade animation.
+ *
+ * @param state Pointer to the test state.
+ */
+static void fade_test(void **state)
+{
+    (void)state; // Unused parameter
+
+    status_leds_color_t buffer[STATUS_LEDS_MAX_COUNT];
+
+    for (uint8_t i = 0; i < STATUS_LEDS_MAX_COUNT; i++)
+    {
+        buffer[i].r = 200;
+        buffer[i].g = 100;
+        buffer[i].b = 1;
+    }
+
+    // Expect timer to be set
+    expect_any(set_timer, timeout);
+    expect_any(set_timer, callback);
+    expect_any(set_timer, repeat);
+
+    fade_animation_setup(buffer, 100, NULL);
+
+    // First tick is 25% of the way through the fade
+    expect_function_call(status_leds_refresh);
+    will_return(status_leds_refresh, LCM_SUCCESS);
+    call_timer_callback(1, 0);
+
+    for (uint8_t i = 0; i < STATUS_LEDS_MAX_COUNT; i++)
+    {
+        assert_int_equal(buffer[i].r, 150);
+        assert_int_equal(buffer[i].g, 75);
+        assert_int_equal(buffer[i].b, 0);
+    }
+}
+
+/**
+ * @brief Test the static bar graph.
+ *
+ * @param state Pointer to the test state.
+ */
+static void bar_fill_test(void **state)
+{
+    (void)state; // Unused parameter
+
+    status_leds_color_t buffer[STATUS_LEDS_MAX_COUNT];
+    const status_leds_color_t white = {0xFF, 0xFF, 0xFF};
+
+    // Four and a half LEDs
+    bar_fill(buffer, (4 * 256) + 128, &white);
+
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        assert_int_equal(buffer[i].r, 0xFF);
+    }
+    assert_in_range(buffer[5].r, 1, 0xFE);
+    assert_true(buffer[6].r < buffer[5].r);
+    assert_int_equal(buffer[STATUS_LEDS_MAX_COUNT - 1].r, 0);
+
+    // An empty bar is dark
+    bar_fill(buffer, -256 * 4, &white);
+    for (uint8_t i = 0; i < STATUS_LEDS_MAX_COUNT; i++)
+    {
+        assert_int_equal(buffer[i].g, 0);
+    }
+}
+
+/**
+ * @brief Test that a crossfade runs on the animation timer by itself.
+ *
+ * @param state Pointer to the test state.
+ */
+static void crossfade_test(void **state)
+{
+    (void)state; // Unused parameter
+
+    // No animation is running, so the crossfade starts the timer
+    expect_any(set_timer, timeout);
+    expect_any(set_timer, callback);
+    expect_any(set_timer, repeat);
+
+    animation_crossfade_start(5U);
+    assert_int_equal(animation_crossfade_alpha(), 255);
+
+    for (uint8_t i = 1; i < 5; i++)
+    {
+        expect_function_call(status_leds_refresh);
+        will_return(status_leds_refresh, LCM_SUCCESS);
+        call_timer_callback(1, i);
+        assert_int_equal(animation_crossfade_alpha(), 255 - (51 * i));
+    }
+
+    // The last frame completes the crossfade and releases the timer
+    expect_function_call(status_leds_refresh);
+    will_return(status_leds_refresh, LCM_SUCCESS);
+    expect_any(cancel_timer, timer_id);
+    will_return(cancel_timer, LCM_SUCCESS);
+    call_timer_callback(1, 5);
+    assert_int_equal(animation_crossfade_alpha(), 0);
+}
+
+/**
+ * @brief Test that a bound scan follows the live modulation.
+ *
+ * @param state Pointer to the test state.
+ */
+static void modulation_test(void **state)
+{
+    (void)state; // Unused parameter
+
+    status_leds_color_t plain[STATUS_LEDS_MAX_COUNT];
+    status_leds_color_t modulated[STATUS_LEDS_MAX_COUNT];
+    const status_leds_color_t white = {0xFF, 0xFF, 0xFF};
+    uint8_t peak = 0U;
+
+    // Five frames of a scan at its normal speed
+    expect_any(set_timer, timeout);
+    expect_any(set_timer, callback);
+    expect_any(set_timer, repeat);
+    scan_animation_setup(plain, SCAN_DIRECTION_SINE, COLOR_MODE_RGB, 2000.0f, SIGMA_DEFAULT, 0.0f,
+                         0.0f, 0.0f, SCAN_START_DEFAULT, SCAN_END_NEVER, 0.0f, &white);
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        expect_function_call(status_leds_refresh);
+        will_return(status_leds_refresh, LCM_SUCCESS);
+        call_timer_callback(1, i);
+    }
+
+    // At full strength it moves four times as fast, so it gets to the same
+    // place in two frames
+    expect_any(is_timer_active, timer_id);
+    will_return(is_timer_active, true);
+    scan_animation_setup(modulated, SCAN_DIRECTION_SINE, COLOR_MODE_RGB, 2000.0f, SIGMA_DEFAULT,
+                         0.0f, 0.0f, 0.0f, SCAN_START_DEFAULT, SCAN_END_NEVER, 0.0f, &white);
+    animation_modulate(ANIMATION_MOD_SPEED | ANIMATION_MOD_BRIGHTNESS);
+    animation_set_modulation(255U);
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        expect_function_call(status_leds_refresh);
+        will_return(status_leds_refresh, LCM_SUCCESS);
+        call_timer_callback(1, i);
+    }
+
+    for (uint8_t i = 0; i < STATUS_LEDS_MAX_COUNT; i++)
+    {
+        assert_in_range(modulated[i].r, (plain[i].r > 3U) ? plain[i].r - 3U : 0U, plain[i].r);
+    }
+
+    // At rest the bound brightness drops to a quarter
+    animation_set_modulation(0U);
+    expect_function_call(status_leds_refresh);
+    will_return(status_leds_refresh, LCM_SUCCESS);
+    call_timer_callback(1, 2);
+
+    for (uint8_t i = 0; i < STATUS_LEDS_MAX_COUNT; i++)
+    {
+        peak = MAX(peak, modulated[i].g);
+    }
+    assert_in_range(peak, 1U, 64U);
+}
+
+void params_test(void **state)
+{
+    (void)state; // Unused parameter
+
+    animation_params_t params = {.type = ANIMATION_TYPE_SCAN,
+                                 .mode = SCAN_DIRECTION_SINE,
+                                 .color_mode = COLOR_MODE_HSV_SINE,
+                                 .period = 2000U,
+                                 .sigma = 70U,
+                                 .hue_min = -30,
+                                 .hue_max = 30,
+                                 .color_speed = 3000U,
+                                 .scan_end = SCAN_END_NEVER};
+    assert_true(animation_params_valid(&params));
+
+    // Zero width scan
+    params.sigma = 0U;
+    assert_false(animation_params_valid(&params));
+
+    // Too narrow for the 32 bit gaussian lookup
+    params.sigma = ANIMATION_SIGMA_MIN - 1U;
+    assert_false(animation_params_valid(&params));
+    params.sigma = ANIMATION_SIGMA_MIN;
+    assert_true(animation_params_valid(&params));
+    params.sigma = 70U;
+
+    // Hue out of range
+    params.hue_max = 400;
+    assert_false(animation_params_valid(&params));
+    params.hue_max = 30;
+
+    // Unknown direction
+    params.mode = SCAN_DIRECTION_SINE + 1U;
+    assert_false(animation_params_valid(&params));
+
+    // Fill with an animated brightness needs a speed
+    params.type = ANIMATION_TYPE_FILL;
+    params.mode = FILL_MODE_SOLID;
+    params.brightness_mode = BRIGHTNESS_MODE_SINE;
+    params.brightness_speed = 0U;
+    assert_false(animation_params_valid(&params));
+    params.brightness_speed = 1000U;
+    assert_true(animation_params_valid(&params));
+
+    // Unknown type, e.g. erased EEPROM
+    params.type = 0xFFU;
+    assert_false(animation_params_valid(&params));
+    assert_false(animation_params_valid(NULL));
+}
+
 int test_animations_teardown(void **state)
 {
     (void)state; // Unused parameter
@@ -98,5 +392,13 @@ int test_animations_teardown(void **state)
 
 const struct CMUnitTest animations_tests[] = {
     cmocka_unit_test_setup_teardown(fill_test, test_animations_setup, test_animations_teardown),
+    cmocka_unit_test(gaussian_test),
+    cmocka_unit_test(hue_test),
+    cmocka_unit_test_setup_teardown(fade_test, test_animations_setup, test_animations_teardown),
+    cmocka_unit_test(params_test),
+    cmocka_unit_test(bar_fill_test),
+    cmocka_unit_test_setup(crossfade_test, test_animations_setup),
+    cmocka_unit_test_setup_teardown(modulation_test, test_animations_setup,
+                                    test_animations_teardown),
 };
 #endif
\ No newline at end of file
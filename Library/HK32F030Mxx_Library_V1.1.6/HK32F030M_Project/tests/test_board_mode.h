@@ -29,6 +29,29 @@
 #include "mock_event_queue.h"
 #include "mock_timer.h"
 #include "config.h"
+#include "vesc_serial.h"
+
+// Telemetry snapshot returned by the mocked vesc_serial_get_telemetry()
+static vesc_telemetry_t board_mode_telemetry;
+
+/**
+ * @brief Sets the mocked telemetry and raises EVENT_TELEMETRY_UPDATED
+ *
+ * @param changed The mask of telemetry fields that changed
+ * @param duty_cycle The duty cycle in the snapshot (0.1%)
+ * @param rpm The RPM in the snapshot
+ */
+static void send_telemetry(telemetry_fields_t changed, int16_t duty_cycle, int32_t rpm)
+{
+    event_data_t event_data = {0};
+
+    board_mode_telemetry.duty_cycle = duty_cycle;
+    board_mode_telemetry.rpm = rpm;
+    will_return(vesc_serial_get_telemetry, &board_mode_telemetry);
+
+    event_data.telemetry_changed = changed;
+    event_queue_call_mocked_callback(EVENT_TELEMETRY_UPDATED, &event_data);
+}
 
 /**
  * @brief Initializes the board mode for testing
@@ -45,26 +68,31 @@ int board_mode_setup(void **state)
     // Reset event queue and timer
     event_queue_init();
     timer_init();
+    memset(&board_mode_telemetry, 0, sizeof(board_mode_telemetry));
 
     // Board mode subscribes to a lot of events
     expect_value(subscribe_event, event, EVENT_BUTTON_UP);
     expect_any(subscribe_event, callback);
+    expect_value(subscribe_event, event, EVENT_BUTTON_DOWN);
+    expect_any(subscribe_event, callback);
     expect_value(subscribe_event, event, EVENT_COMMAND_SHUTDOWN);
     expect_any(subscribe_event, callback);
     expect_value(subscribe_event, event, EVENT_COMMAND_BOOT);
     expect_any(subscribe_event, callback);
     expect_value(subscribe_event, event, EVENT_COMMAND_MODE_CONFIG);
     expect_any(subscribe_event, callback);
-    expect_value(subscribe_event, event, EVENT_RPM_CHANGED);
-    expect_any(subscribe_event, callback);
     expect_value(subscribe_event, event, EVENT_EMERGENCY_FAULT);
     expect_any(subscribe_event, callback);
     expect_value(subscribe_event, event, EVENT_FOOTPAD_CHANGED);
     expect_any(subscribe_event, callback);
     expect_value(subscribe_event, event, EVENT_VESC_ALIVE);
     expect_any(subscribe_event, callback);
-    expect_value(subscribe_event, event, EVENT_DUTY_CYCLE_CHANGED);
+    expect_value(subscribe_event, event, EVENT_TELEMETRY_UPDATED);
     expect_any(subscribe_event, callback);
+#ifdef ENABLE_IMU_EVENTS
+    expect_value(vesc_serial_declare_demand, fields, TELEMETRY_IMU_ROLL);
+    expect_value(vesc_serial_declare_demand, modes, BOARD_MODE_MASK(BOARD_MODE_IDLE));
+#endif
 
     board_mode_init();
 
@@ -105,7 +133,7 @@ void board_mode_to_idle(void)
     // The board is now in booting mode, no other events should trigger anything
     event_queue_call_mocked_callback(EVENT_BUTTON_UP, &null_event_data);
     event_queue_call_mocked_callback(EVENT_FOOTPAD_CHANGED, &null_event_data);
-    event_queue_call_mocked_callback(EVENT_RPM_CHANGED, &null_event_data);
+    send_telemetry(TELEMETRY_RPM, 0, 100);
 
     // Except the VESC_ALIVE event, which takes us to idle mode
     expect_value(event_queue_push, event, EVENT_BOARD_MODE_CHANGED);
@@ -282,8 +310,9 @@ void step_on_board(void)
                  (uintmax_t)&expected_state);
 
     // The code will check the vesc_serial parameters
-    will_return(vesc_serial_get_duty_cycle, 0.0f);
-    will_return(vesc_serial_get_rpm, 0);
+    board_mode_telemetry.duty_cycle = 0;
+    board_mode_telemetry.rpm = 0;
+    will_return(vesc_serial_get_telemetry, &board_mode_telemetry);
 
     // The code will also disable the idle timer
     expect_any(is_timer_active, timer_id);
@@ -308,7 +337,8 @@ void step_off_board(void)
                  (uintmax_t)&expected_state);
 
     // The code will check the RPM
-    will_return(vesc_serial_get_rpm, 0);
+    board_mode_telemetry.rpm = 0;
+    will_return(vesc_serial_get_telemetry, &board_mode_telemetry);
 
     // Going to idle mode, so expect an idle timer
     expect_any(set_timer, timeout);
@@ -347,7 +377,7 @@ void trigger_emergency_fault()
     event_data_t fault_event_data = {0};
     expect_value(event_queue_push, event, EVENT_BOARD_MODE_CHANGED);
     expected_state.mode = BOARD_MODE_FAULT;
-    expected_state.submode = BOARD_SUBMODE_UNDEFINED;
+    expected_state.submode = BOARD_SUBMODE_FAULT_INTERNAL;
     expect_check(event_queue_push, data, validate_board_mode_event_data,
                  (uintmax_t)&expected_state);
 
@@ -390,28 +420,21 @@ void test_board_mode_footpads(void **state)
 void test_board_mode_duty_cycle(void **state)
 {
     (void)state;
-    event_data_t duty_cycle_event_data = {0};
     board_mode_event_data_t expected_state = {0};
 
     // Transition to idle
     board_mode_to_idle();
 
     // Duty cyle shouldn't do anything in idle mode
-    duty_cycle_event_data.duty_cycle = 0.5f;
-    event_queue_call_mocked_callback(EVENT_DUTY_CYCLE_CHANGED, &duty_cycle_event_data);
+    send_telemetry(TELEMETRY_DUTY_CYCLE, 5, 0);
 
     // Step on board
     step_on_board();
 
     // Low duty cycle shouldn't do anything
-    will_return(vesc_serial_get_duty_cycle, 10.0f);
-    will_return(vesc_serial_get_rpm, 8);
-
-    event_queue_call_mocked_callback(EVENT_DUTY_CYCLE_CHANGED, &duty_cycle_event_data);
+    send_telemetry(TELEMETRY_DUTY_CYCLE, 100, 8);
 
     // High duty cycle should trigger warning
-    will_return(vesc_serial_get_duty_cycle, 85.0f);
-    will_return(vesc_serial_get_rpm, 8);
 
     // Riding mode will disable the idle timer
     expect_any(is_timer_active, timer_id);
@@ -423,11 +446,9 @@ void test_board_mode_duty_cycle(void **state)
     expect_check(event_queue_push, data, validate_board_mode_event_data,
                  (uintmax_t)&expected_state);
 
-    event_queue_call_mocked_callback(EVENT_DUTY_CYCLE_CHANGED, &duty_cycle_event_data);
+    send_telemetry(TELEMETRY_DUTY_CYCLE, 850, 8);
 
     // Higher duty cycle should trigger danger
-    will_return(vesc_serial_get_duty_cycle, 95.0f);
-    will_return(vesc_serial_get_rpm, 8);
 
     // Riding mode will disable the idle timer
     expect_any(is_timer_active, timer_id);
@@ -439,11 +460,9 @@ void test_board_mode_duty_cycle(void **state)
     expect_check(event_queue_push, data, validate_board_mode_event_data,
                  (uintmax_t)&expected_state);
 
-    event_queue_call_mocked_callback(EVENT_DUTY_CYCLE_CHANGED, &duty_cycle_event_data);
+    send_telemetry(TELEMETRY_DUTY_CYCLE, 950, 8);
 
     // Slowing down should go back to warning
-    will_return(vesc_serial_get_duty_cycle, 84.0f);
-    will_return(vesc_serial_get_rpm, 8);
 
     // Riding mode will disable the idle timer
     expect_any(is_timer_active, timer_id);
@@ -455,7 +474,7 @@ void test_board_mode_duty_cycle(void **state)
     expect_check(event_queue_push, data, validate_board_mode_event_data,
                  (uintmax_t)&expected_state);
 
-    event_queue_call_mocked_callback(EVENT_DUTY_CYCLE_CHANGED, &duty_cycle_event_data);
+    send_telemetry(TELEMETRY_DUTY_CYCLE, 840, 8);
 }
 
 void test_board_mode_emergency_fault(void **state)
@@ -466,21 +485,100 @@ void test_board_mode_emergency_fault(void **state)
     trigger_emergency_fault();
 }
 
+void test_board_mode_vesc_fault(void **state)
+{
+    (void)state;
+    board_mode_event_data_t expected_state = {0};
+
+    // Transition to idle
+    board_mode_to_idle();
+
+    // A VESC fault code puts the board into VESC fault mode
+    expect_value(event_queue_push, event, EVENT_BOARD_MODE_CHANGED);
+    expected_state.mode = BOARD_MODE_FAULT;
+    expected_state.submode = BOARD_SUBMODE_FAULT_VESC;
+    expect_check(event_queue_push, data, validate_board_mode_event_data,
+                 (uintmax_t)&expected_state);
+
+    // Fault mode will disable the idle timer
+    expect_any(is_timer_active, timer_id);
+    will_return(is_timer_active, true);
+    expect_any(cancel_timer, timer_id);
+    will_return(cancel_timer, LCM_SUCCESS);
+
+    board_mode_telemetry.fault = 1U;
+    send_telemetry(TELEMETRY_FAULT, 0, 0);
+    assert_int_equal(board_mode_get(), BOARD_MODE_FAULT);
+
+    // Clearing the fault returns the board to active idle
+    expect_value(event_queue_push, event, EVENT_BOARD_MODE_CHANGED);
+    expected_state.mode = BOARD_MODE_IDLE;
+    expected_state.submode = BOARD_SUBMODE_IDLE_ACTIVE;
+    expect_check(event_queue_push, data, validate_board_mode_event_data,
+                 (uintmax_t)&expected_state);
+
+    // Going to idle mode, so expect an idle timer
+    expect_any(set_timer, timeout);
+    expect_any(set_timer, callback);
+    expect_any(set_timer, repeat);
+
+    board_mode_telemetry.fault = 0U;
+    send_telemetry(TELEMETRY_FAULT, 0, 0);
+    assert_int_equal(board_submode_get(), BOARD_SUBMODE_IDLE_ACTIVE);
+}
+
+void test_board_mode_vesc_comm_timeout(void **state)
+{
+    (void)state;
+    board_mode_event_data_t expected_state = {0};
+    event_data_t event_data = {0};
+
+    // Transition to idle
+    board_mode_to_idle();
+
+    // Losing the VESC puts the board into VESC fault mode
+    expect_value(event_queue_push, event, EVENT_BOARD_MODE_CHANGED);
+    expected_state.mode = BOARD_MODE_FAULT;
+    expected_state.submode = BOARD_SUBMODE_FAULT_VESC;
+    expect_check(event_queue_push, data, validate_board_mode_event_data,
+                 (uintmax_t)&expected_state);
+
+    // Fault mode will disable the idle timer
+    expect_any(is_timer_active, timer_id);
+    will_return(is_timer_active, true);
+    expect_any(cancel_timer, timer_id);
+    will_return(cancel_timer, LCM_SUCCESS);
+
+    event_data.emergency_fault = EMERGENCY_FAULT_VESC_COMM_TIMEOUT;
+    event_queue_call_mocked_callback(EVENT_EMERGENCY_FAULT, &event_data);
+
+    // When the VESC answers again, the board returns to active idle
+    expect_value(event_queue_push, event, EVENT_BOARD_MODE_CHANGED);
+    expected_state.mode = BOARD_MODE_IDLE;
+    expected_state.submode = BOARD_SUBMODE_IDLE_ACTIVE;
+    expect_check(event_queue_push, data, validate_board_mode_event_data,
+                 (uintmax_t)&expected_state);
+
+    // Going to idle mode, so expect an idle timer
+    expect_any(set_timer, timeout);
+    expect_any(set_timer, callback);
+    expect_any(set_timer, repeat);
+
+    will_return(vesc_serial_get_telemetry, &board_mode_telemetry);
+    event_queue_call_mocked_callback(EVENT_VESC_ALIVE, &event_data);
+    assert_int_equal(board_submode_get(), BOARD_SUBMODE_IDLE_ACTIVE);
+}
+
 void move_board_forward(void)
 {
     // In idle mode, RPM changes should transition to riding mode
     board_mode_event_data_t expected_state = {0};
-    event_data_t rpm_event_data = {0};
     expect_value(event_queue_push, event, EVENT_BOARD_MODE_CHANGED);
     expected_state.mode = BOARD_MODE_RIDING;
     expected_state.submode = BOARD_SUBMODE_RIDING_SLOW;
     expect_check(event_queue_push, data, validate_board_mode_event_data,
                  (uintmax_t)&expected_state);
 
-    // The code will check the vesc_serial parameters
-    will_return(vesc_serial_get_duty_cycle, 0.0f);
-    will_return(vesc_serial_get_rpm, 100U);
-
     // The code will also disable the idle timer
     expect_any(is_timer_active, timer_id);
     will_return(is_timer_active, true);
@@ -488,15 +586,13 @@ void move_board_forward(void)
     will_return(cancel_timer, LCM_SUCCESS);
 
     // Move board forward
-    rpm_event_data.rpm = 100;
-    event_queue_call_mocked_callback(EVENT_RPM_CHANGED, &rpm_event_data);
+    send_telemetry(TELEMETRY_RPM, 0, 100);
 }
 
 void stop_riding(void)
 {
     // In idle mode, RPM changes should transition to riding mode
     board_mode_event_data_t expected_state = {0};
-    event_data_t rpm_event_data = {0};
     expect_value(event_queue_push, event, EVENT_BOARD_MODE_CHANGED);
     expected_state.mode = BOARD_MODE_IDLE;
     expected_state.submode = BOARD_SUBMODE_IDLE_ACTIVE;
@@ -512,19 +608,16 @@ void stop_riding(void)
     expect_any(set_timer, repeat);
 
     // Stop riding
-    rpm_event_data.rpm = 0;
-    event_queue_call_mocked_callback(EVENT_RPM_CHANGED, &rpm_event_data);
+    send_telemetry(TELEMETRY_RPM, 0, 0);
 }
 
 void test_board_mode_rpm(void **state)
 {
     (void)state;
-    event_data_t rpm_event_data = {0};
     board_mode_event_data_t expected_state = {0};
 
     // RPM changes shouldn't do anything in off state
-    rpm_event_data.rpm = 100;
-    event_queue_call_mocked_callback(EVENT_RPM_CHANGED, &rpm_event_data);
+    send_telemetry(TELEMETRY_RPM, 0, 100);
 
     // Transition to idle
     board_mode_to_idle();
@@ -533,10 +626,7 @@ void test_board_mode_rpm(void **state)
     move_board_forward();
 
     // RPM updates shouldn't do change any states while moving
-    rpm_event_data.rpm = -150;
-    will_return(vesc_serial_get_duty_cycle, 0.0f);
-    will_return(vesc_serial_get_rpm, -150);
-    event_queue_call_mocked_callback(EVENT_RPM_CHANGED, &rpm_event_data);
+    send_telemetry(TELEMETRY_RPM, 0, -150);
 
     // Unless we go faster, at normal speed
     expect_value(event_queue_push, event, EVENT_BOARD_MODE_CHANGED);
@@ -545,16 +635,11 @@ void test_board_mode_rpm(void **state)
     expect_check(event_queue_push, data, validate_board_mode_event_data,
                  (uintmax_t)&expected_state);
 
-    // The code will check the vesc_serial parameters
-    will_return(vesc_serial_get_duty_cycle, 50.0f);
-    will_return(vesc_serial_get_rpm, SLOW_RPM_THRESHOLD + 100);
-
     // Setting RPM checks the idle timer
     expect_any(is_timer_active, timer_id);
     will_return(is_timer_active, false);
 
-    rpm_event_data.rpm = SLOW_RPM_THRESHOLD + 100;
-    event_queue_call_mocked_callback(EVENT_RPM_CHANGED, &rpm_event_data);
+    send_telemetry(TELEMETRY_RPM, 500, SLOW_RPM_THRESHOLD + 100);
 
     // stop board
     stop_riding();
@@ -567,6 +652,8 @@ const struct CMUnitTest board_mode_tests[] = {
     cmocka_unit_test_setup(test_board_mode_command_shutdown, board_mode_setup),
     cmocka_unit_test_setup(test_board_mode_footpads, board_mode_setup),
     cmocka_unit_test_setup(test_board_mode_emergency_fault, board_mode_setup),
+    cmocka_unit_test_setup(test_board_mode_vesc_fault, board_mode_setup),
+    cmocka_unit_test_setup(test_board_mode_vesc_comm_timeout, board_mode_setup),
     cmocka_unit_test_setup(test_board_mode_duty_cycle, board_mode_setup),
     cmocka_unit_test_setup(test_board_mode_rpm, board_mode_setup),
 };
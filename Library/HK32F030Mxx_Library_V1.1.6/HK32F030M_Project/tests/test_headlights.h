@@ -30,6 +30,7 @@
 #include "mock_event_queue.h"
 #include "mock_timer.h"
 #include "settings.h"
+#include "vesc_serial.h"
 
 /**
  * @brief Setup function for headlights tests
@@ -54,7 +55,7 @@ int headlights_setup(void **state)
     expect_value(headlights_hw_set_direction, direction, HEADLIGHTS_DIRECTION_NONE);
     expect_value(subscribe_event, event, EVENT_BOARD_MODE_CHANGED);
     expect_any(subscribe_event, callback);
-    expect_value(subscribe_event, event, EVENT_RPM_CHANGED);
+    expect_value(subscribe_event, event, EVENT_TELEMETRY_UPDATED);
     expect_any(subscribe_event, callback);
     expect_value(subscribe_event, event, EVENT_COMMAND_TOGGLE_LIGHTS);
     expect_any(subscribe_event, callback);
@@ -62,6 +63,10 @@ int headlights_setup(void **state)
     expect_any(subscribe_event, callback);
     expect_value(subscribe_event, event, EVENT_COMMAND_SETTINGS_CHANGED);
     expect_any(subscribe_event, callback);
+#ifdef ENABLE_IMU_EVENTS
+    expect_value(vesc_serial_declare_demand, fields, TELEMETRY_IMU_PITCH);
+    expect_value(vesc_serial_declare_demand, modes, BOARD_MODE_MASK(BOARD_MODE_IDLE));
+#endif
 
     headlights_init();
     return 0;
@@ -150,11 +155,95 @@ void test_headlights_idle_default(void **state)
     event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
 }
 
+void test_headlights_single_timer(void **state)
+{
+    (void)state; // Unused
+
+    settings_t *settings = settings_get();
+    event_data_t data = {0};
+    const uint8_t ticks = (FADE_PERIOD / 20U) + 1U; // 20 ms ticks to the end of a fade
+
+    // Idle starts the fade down to the idle brightness
+    test_headlights_idle_default(state);
+
+    // Turning the headlights off fades them out on the same timer
+    settings->enable_headlights = false;
+    expect_any(headlights_hw_set_brightness, brightness);
+    event_queue_call_mocked_callback(EVENT_COMMAND_TOGGLE_LIGHTS, &data);
+
+    // One write per tick, however many animations are running
+    for (uint8_t i = 1U; i < ticks; i++)
+    {
+        expect_any(headlights_hw_set_brightness, brightness);
+        call_timer_callback(1, i * 20U);
+    }
+
+    // Both finish together, dark, and the timer stops itself
+    expect_value(headlights_hw_set_brightness, brightness, 0U);
+    expect_value(cancel_timer, timer_id, 1);
+    will_return(cancel_timer, LCM_SUCCESS);
+    call_timer_callback(1, ticks * 20U);
+}
+
+#ifdef ENABLE_IMU_EVENTS
+void test_headlights_pitch(void **state)
+{
+    (void)state; // Unused
+
+    vesc_telemetry_t telemetry = {0};
+    event_data_t data = {0};
+
+    // Boot so the headlights are on
+    test_headlights_boot(state);
+
+    // Pointing the board straight up turns the headlights off
+    telemetry.imu_pitch = 7000;
+    will_return(vesc_serial_get_telemetry, &telemetry);
+    expect_value(headlights_hw_set_brightness, brightness, 0U);
+
+    data.telemetry_changed = TELEMETRY_IMU_PITCH;
+    event_queue_call_mocked_callback(EVENT_TELEMETRY_UPDATED, &data);
+
+    // Putting it back down restores them
+    telemetry.imu_pitch = 500;
+    will_return(vesc_serial_get_telemetry, &telemetry);
+    expect_value(headlights_hw_set_brightness, brightness, HEADLIGHTS_HW_MAX_BRIGHTNESS);
+
+    event_queue_call_mocked_callback(EVENT_TELEMETRY_UPDATED, &data);
+}
+#endif
+
+void test_headlights_settings_changed(void **state)
+{
+    event_data_t data = {0};
+    vesc_telemetry_t telemetry = {0};
+    settings_t *settings = settings_get();
+
+    // Boot so the headlights are on
+    test_headlights_boot(state);
+
+    // A new brightness setting is not picked up from other events
+    settings->headlight_brightness = 0.5f;
+    will_return(vesc_serial_get_telemetry, &telemetry);
+    expect_value(headlights_hw_set_brightness, brightness, HEADLIGHTS_HW_MAX_BRIGHTNESS);
+    data.telemetry_changed = TELEMETRY_BATTERY_LEVEL;
+    event_queue_call_mocked_callback(EVENT_TELEMETRY_UPDATED, &data);
+
+    // Only once the settings change
+    expect_value(headlights_hw_set_brightness, brightness, HEADLIGHTS_HW_MAX_BRIGHTNESS / 2U);
+    event_queue_call_mocked_callback(EVENT_COMMAND_SETTINGS_CHANGED, &data);
+}
+
 const struct CMUnitTest headlights_tests[] = {
     cmocka_unit_test_setup(test_headlights_boot, headlights_setup),
     cmocka_unit_test_setup(test_headlights_riding, headlights_setup),
     cmocka_unit_test_setup(test_headlights_idle_active, headlights_setup),
     cmocka_unit_test_setup(test_headlights_idle_default, headlights_setup),
+    cmocka_unit_test_setup(test_headlights_single_timer, headlights_setup),
+    cmocka_unit_test_setup(test_headlights_settings_changed, headlights_setup),
+#ifdef ENABLE_IMU_EVENTS
+    cmocka_unit_test_setup(test_headlights_pitch, headlights_setup),
+#endif
 };
 
 #endif // TEST_HEADLIGHTS_H
\ No newline at end of file
@@ -30,6 +30,7 @@
 #include "mock_event_queue.h"
 #include "mock_animations.h"
 #include "mock_status_leds_hw.h"
+#include "vesc_serial.h"
 #include "timer.h"
 #include "config.h"
 
@@ -38,7 +39,7 @@ static settings_t *settings = NULL; // Global variable to hold the settings for
 int validate_status_leds_buffer(const status_leds_color_t *expected_buffer,
                                 const status_leds_color_t *actual_buffer)
 {
-    for (uint8_t i = 0; i < STATUS_LEDS_COUNT; i++)
+    for (uint8_t i = 0; i < STATUS_LEDS_MAX_COUNT; i++)
     {
         assert_int_equal(expected_buffer[i].r, actual_buffer[i].r);
         assert_int_equal(expected_buffer[i].g, actual_buffer[i].g);
@@ -48,7 +49,29 @@ int validate_status_leds_buffer(const status_leds_color_t *expected_buffer,
     return 1;
 }
 
-int test_status_leds_setup(void **state)
+/**
+ * @brief Sends a telemetry update reporting a battery level change.
+ */
+static void send_battery_level_changed(void)
+{
+    event_data_t telemetry_data = {0};
+    telemetry_data.telemetry_changed = TELEMETRY_BATTERY_LEVEL;
+    event_queue_call_mocked_callback(EVENT_TELEMETRY_UPDATED, &telemetry_data);
+}
+
+/**
+ * @brief Expect the previous display to be crossfaded on a mode change.
+ */
+void expect_crossfade(void)
+{
+    expect_value(animation_crossfade_start, frames, STATUS_LEDS_CROSSFADE_FRAMES);
+    expect_function_call(animation_crossfade_start);
+}
+
+/**
+ * @brief Initializes the status LEDs with two strips of the given lengths.
+ */
+static int status_leds_setup_strips(uint8_t first_count, uint8_t second_count)
 {
     // Reset event queue and timer
     event_queue_init();
@@ -60,21 +83,21 @@ int test_status_leds_setup(void **state)
     settings->status_brightness = 1.0f;
     settings->enable_status_leds = true;
     settings->personal_color = 123.0f;
+    settings->status_leds_strips[0].count = first_count;
+    settings->status_leds_strips[1].count = second_count;
 
-    expect_any(status_leds_hw_init, buffer);
     expect_function_call(status_leds_hw_init);
     expect_value(status_leds_hw_set_brightness, brightness, 1.0f);
     expect_function_call(stop_animation);
 
-    status_leds_color_t expected_buffer[STATUS_LEDS_COUNT] = {0};
-    for (uint8_t i = 0; i < STATUS_LEDS_COUNT; i++)
+    status_leds_color_t expected_buffer[STATUS_LEDS_MAX_COUNT] = {0};
+    for (uint8_t i = 0; i < STATUS_LEDS_MAX_COUNT; i++)
     {
         expected_buffer[i].r = 0x00;
         expected_buffer[i].g = 0x00;
         expected_buffer[i].b = 0x00;
     }
 
-    expect_function_call(status_leds_hw_refresh);
     expect_value(status_leds_hw_enable, enable, true);
     expect_value(hsl_to_rgb, h, settings->personal_color);
     expect_value(hsl_to_rgb, s, SATURATION_DEFAULT);
@@ -86,7 +109,7 @@ int test_status_leds_setup(void **state)
     expect_any(subscribe_event, callback);
     expect_value(subscribe_event, event, EVENT_FOOTPAD_CHANGED);
     expect_any(subscribe_event, callback);
-    expect_value(subscribe_event, event, EVENT_BATTERY_LEVEL_CHANGED);
+    expect_value(subscribe_event, event, EVENT_TELEMETRY_UPDATED);
     expect_any(subscribe_event, callback);
     expect_value(subscribe_event, event, EVENT_COMMAND_TOGGLE_LIGHTS);
     expect_any(subscribe_event, callback);
@@ -96,13 +119,31 @@ int test_status_leds_setup(void **state)
     expect_any(subscribe_event, callback);
     expect_value(subscribe_event, event, EVENT_COMMAND_SETTINGS_CHANGED);
     expect_any(subscribe_event, callback);
+#ifdef ENABLE_IMU_EVENTS
+    expect_value(vesc_serial_declare_demand, fields, TELEMETRY_IMU_ROLL);
+    expect_value(vesc_serial_declare_demand, modes, BOARD_MODE_MASK(BOARD_MODE_IDLE));
+#endif
 
     status_leds_init();
+
+    // The LEDs are cleared once the event loop pass ends
+    expect_function_call(status_leds_hw_refresh);
+    status_leds_flush();
     validate_status_leds_buffer(expected_buffer, mock_status_leds_hw_get_buffer());
 
     return 0;
 }
 
+int test_status_leds_setup(void **state)
+{
+    return status_leds_setup_strips(STATUS_LEDS_MAX_COUNT, 0U);
+}
+
+int test_status_leds_chained_setup(void **state)
+{
+    return status_leds_setup_strips(4U, 4U);
+}
+
 /**
  * @brief Test that the status LEDs are off when the board is turned off.
  *
@@ -113,8 +154,8 @@ int test_status_leds_setup(void **state)
 static void test_status_leds_off(void **state)
 {
     // Turn on all the LEDs for setup
-    status_leds_color_t expected_buffer[STATUS_LEDS_COUNT] = {0};
-    for (uint8_t i = 0; i < STATUS_LEDS_COUNT; i++)
+    status_leds_color_t expected_buffer[STATUS_LEDS_MAX_COUNT] = {0};
+    for (uint8_t i = 0; i < STATUS_LEDS_MAX_COUNT; i++)
     {
         expected_buffer[i].r = 0xFF;
         expected_buffer[i].g = 0xFF;
@@ -125,9 +166,10 @@ static void test_status_leds_off(void **state)
     color.r = 0xFF;
     color.g = 0xFF;
     color.b = 0xFF;
-    status_leds_set_color(&color, 0, STATUS_LEDS_COUNT - 1);
+    status_leds_set_color(&color, 0, STATUS_LEDS_MAX_COUNT - 1);
     expect_function_call(status_leds_hw_refresh);
     status_leds_refresh();
+    status_leds_flush();
     validate_status_leds_buffer(expected_buffer, mock_status_leds_hw_get_buffer());
 
     // Set the board mode to OFF
@@ -136,7 +178,7 @@ static void test_status_leds_off(void **state)
     data.board_mode.submode = BOARD_SUBMODE_UNDEFINED;
 
     // All LEDs should be off
-    for (uint8_t i = 0; i < STATUS_LEDS_COUNT; i++)
+    for (uint8_t i = 0; i < STATUS_LEDS_MAX_COUNT; i++)
     {
         expected_buffer[i].r = 0x00;
         expected_buffer[i].g = 0x00;
@@ -145,9 +187,11 @@ static void test_status_leds_off(void **state)
 
     will_return(board_mode_get, BOARD_MODE_OFF);
 
+    expect_crossfade();
     expect_function_call(stop_animation);
     expect_function_call(status_leds_hw_refresh);
     event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
+    status_leds_flush();
     validate_status_leds_buffer(expected_buffer, mock_status_leds_hw_get_buffer());
 }
 
@@ -169,7 +213,7 @@ static void test_status_leds_off(void **state)
 static void test_status_leds_set_color(void **state)
 {
     // [X] [X] [R] [R] [R] [X] [X] [X] [X] [X]
-    status_leds_color_t expected_buffer[STATUS_LEDS_COUNT] = {0};
+    status_leds_color_t expected_buffer[STATUS_LEDS_MAX_COUNT] = {0};
     for (uint8_t i = 2; i < 5; i++)
     {
         expected_buffer[i].r = 0xFF;
@@ -182,6 +226,7 @@ static void test_status_leds_set_color(void **state)
     assert_int_equal(LCM_SUCCESS, status_leds_set_color(&color, 2, 4));
     expect_function_call(status_leds_hw_refresh);
     status_leds_refresh();
+    status_leds_flush();
     validate_status_leds_buffer(expected_buffer, mock_status_leds_hw_get_buffer());
 
     // [X] [X] [R] [R] [R] [X] [X] [G] [G] [G]
@@ -196,6 +241,7 @@ static void test_status_leds_set_color(void **state)
     assert_int_equal(LCM_SUCCESS, status_leds_set_color(&color, 7, 9));
     expect_function_call(status_leds_hw_refresh);
     status_leds_refresh();
+    status_leds_flush();
     validate_status_leds_buffer(expected_buffer, mock_status_leds_hw_get_buffer());
 
     // [B] [X] [R] [R] [R] [X] [X] [G] [G] [G]
@@ -211,12 +257,47 @@ static void test_status_leds_set_color(void **state)
     assert_int_equal(LCM_SUCCESS, status_leds_set_color(&color, 0, 0));
     expect_function_call(status_leds_hw_refresh);
     status_leds_refresh();
+    status_leds_flush();
     validate_status_leds_buffer(expected_buffer, mock_status_leds_hw_get_buffer());
 
     // Test invalid range
     assert_int_equal(LCM_ERROR, status_leds_set_color(&color, 4, 2));
     assert_int_equal(LCM_ERROR, status_leds_set_color(NULL, 0, 0));
-    assert_int_equal(LCM_ERROR, status_leds_set_color(NULL, 0, STATUS_LEDS_COUNT));
+    assert_int_equal(LCM_ERROR, status_leds_set_color(NULL, 0, STATUS_LEDS_MAX_COUNT));
+}
+
+/**
+ * @brief Test that refreshes are coalesced and unchanged frames are skipped.
+ *
+ * @param state Unused parameter required by the cmocka framework.
+ */
+static void test_status_leds_refresh_coalesced(void **state)
+{
+    status_leds_color_t color = {0};
+
+    // Several refreshes in one pass send a single frame
+    color.r = 0xFF;
+    assert_int_equal(LCM_SUCCESS, status_leds_set_color(&color, 0, STATUS_LEDS_MAX_COUNT - 1));
+    status_leds_refresh();
+    status_leds_refresh();
+    status_leds_refresh();
+    expect_function_call(status_leds_hw_refresh);
+    status_leds_flush();
+
+    // Nothing requested, nothing sent
+    status_leds_flush();
+
+    // Redrawing the same frame is not sent again
+    assert_int_equal(LCM_SUCCESS, status_leds_set_color(&color, 0, STATUS_LEDS_MAX_COUNT - 1));
+    status_leds_refresh();
+    status_leds_flush();
+
+    // A changed frame is
+    color.g = 0xFF;
+    assert_int_equal(LCM_SUCCESS, status_leds_set_color(&color, 4, 4));
+    status_leds_refresh();
+    expect_function_call(status_leds_hw_refresh);
+    status_leds_flush();
 }
 
 static void test_status_leds_boot(void **state)
@@ -229,6 +310,7 @@ static void test_status_leds_boot(void **state)
     // Disable boot animation
     settings->boot_animation = ANIMATION_OPTION_NONE;
 
+    expect_crossfade();
     // Expect a fade to black
     expect_any(fade_animation_setup, buffer);
     expect_value(fade_animation_setup, period, STATUS_LEDS_FADE_TO_BLACK_TIMEOUT);
@@ -241,6 +323,7 @@ static void test_status_leds_boot(void **state)
     // Set boot animation to fire
     will_return(board_mode_get, BOARD_MODE_BOOTING);
     settings->boot_animation = ANIMATION_OPTION_FIRE;
+    expect_crossfade();
     expect_any(fire_animation_setup, buffer);
     expect_function_call(fire_animation_setup);
     will_return(fire_animation_setup, 1U);
@@ -252,7 +335,7 @@ static void test_status_leds_boot(void **state)
     event_queue_call_mocked_callback(EVENT_FOOTPAD_CHANGED, &data);
 
     will_return(board_mode_get, BOARD_MODE_BOOTING);
-    event_queue_call_mocked_callback(EVENT_BATTERY_LEVEL_CHANGED, &data);
+    send_battery_level_changed();
 }
 
 void expect_fill_animation(void)
@@ -262,7 +345,7 @@ void expect_fill_animation(void)
     expect_any(fill_animation_setup, brightness_mode);
     expect_any(fill_animation_setup, fill_mode);
     expect_value(fill_animation_setup, first_led, 0U);
-    expect_value(fill_animation_setup, last_led, STATUS_LEDS_COUNT - 1U);
+    expect_value(fill_animation_setup, last_led, status_leds_get_count() - 1U);
     expect_any(fill_animation_setup, hue_min);
     expect_any(fill_animation_setup, hue_max);
     expect_any(fill_animation_setup, color_speed);
@@ -293,15 +376,65 @@ void expect_scan_animation(void)
     will_return(scan_animation_setup, 1U);
 }
 
+void expect_bar_fill(void)
+{
+    expect_any(bar_fill, buffer);
+    expect_any(bar_fill, level);
+    expect_any(bar_fill, color);
+    expect_function_call(bar_fill);
+}
+
+/**
+ * @brief Checks that an animation was given the expected color.
+ */
+static int validate_color(const uintmax_t data, const uintmax_t check_data)
+{
+    const status_leds_color_t *received = (const status_leds_color_t *)(uintptr_t)data;
+    const status_leds_color_t *expected = (const status_leds_color_t *)(uintptr_t)check_data;
+
+    assert_int_equal(received->r, expected->r);
+    assert_int_equal(received->g, expected->g);
+    assert_int_equal(received->b, expected->b);
+    return 1;
+}
+
+/**
+ * @brief Expects the fault animation to be started in a given color.
+ */
+static void expect_fault_animation(const status_leds_color_t *color)
+{
+    expect_any(fill_animation_setup, buffer);
+    expect_value(fill_animation_setup, color_mode, COLOR_MODE_RGB);
+    expect_value(fill_animation_setup, brightness_mode, BRIGHTNESS_MODE_SEQUENCE);
+    expect_value(fill_animation_setup, fill_mode, FILL_MODE_SOLID);
+    expect_value(fill_animation_setup, first_led, 0U);
+    expect_value(fill_animation_setup, last_led, status_leds_get_count() - 1U);
+    expect_any(fill_animation_setup, hue_min);
+    expect_any(fill_animation_setup, hue_max);
+    expect_any(fill_animation_setup, color_speed);
+    expect_any(fill_animation_setup, brightness_min);
+    expect_any(fill_animation_setup, brightness_max);
+    expect_any(fill_animation_setup, brightness_speed);
+    expect_any(fill_animation_setup, brightness_sequence);
+    expect_check(fill_animation_setup, rgb, validate_color, (uintmax_t)(uintptr_t)color);
+    expect_function_call(fill_animation_setup);
+    will_return(fill_animation_setup, 1U);
+}
+
 static void test_status_leds_fault(void **state)
 {
     event_data_t data = {0};
+    status_leds_color_t red = {0xFF, 0x00, 0x00};
+    status_leds_color_t magenta = {0xFF, 0x00, 0xFF};
+
+    // A VESC fault flashes red
     data.board_mode.mode = BOARD_MODE_FAULT;
-    data.board_mode.submode = BOARD_SUBMODE_UNDEFINED;
+    data.board_mode.submode = BOARD_SUBMODE_FAULT_VESC;
     will_return(board_mode_get, BOARD_MODE_FAULT);
+    will_return(board_submode_get, BOARD_SUBMODE_FAULT_VESC);
 
-    // Expect a fill animation
-    expect_fill_animation();
+    expect_crossfade();
+    expect_fault_animation(&red);
     event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
 
     // Any non-mode change event should not affect the fault animation
@@ -309,13 +442,25 @@ static void test_status_leds_fault(void **state)
     event_queue_call_mocked_callback(EVENT_FOOTPAD_CHANGED, &data);
 
     will_return(board_mode_get, BOARD_MODE_FAULT);
-    event_queue_call_mocked_callback(EVENT_BATTERY_LEVEL_CHANGED, &data);
+    send_battery_level_changed();
+
+    // An internal fault flashes magenta
+    data.board_mode.submode = BOARD_SUBMODE_FAULT_INTERNAL;
+    will_return(board_mode_get, BOARD_MODE_FAULT);
+    will_return(board_submode_get, BOARD_SUBMODE_FAULT_INTERNAL);
+
+    expect_crossfade();
+    expect_fault_animation(&magenta);
+    event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
 }
 
 static void test_status_leds_toggle(void **state)
 {
     event_data_t data = {0};
-    status_leds_color_t expected_buffer[STATUS_LEDS_COUNT] = {0};
+    vesc_telemetry_t telemetry = {0};
+    status_leds_color_t expected_buffer[STATUS_LEDS_MAX_COUNT] = {0};
+
+    telemetry.battery_level = 900;
 
     // Turn off the LEDs
     settings->enable_status_leds = false;
@@ -331,19 +476,19 @@ static void test_status_leds_toggle(void **state)
 
     // Events should not affect the fade animation
     event_queue_call_mocked_callback(EVENT_FOOTPAD_CHANGED, &data);
-    event_queue_call_mocked_callback(EVENT_BATTERY_LEVEL_CHANGED, &data);
+    send_battery_level_changed();
 
     // Simulate animation completed
     expect_function_call(stop_animation);
 
     // All LEDs should be off
-    for (uint8_t i = 0; i < STATUS_LEDS_COUNT; i++)
+    for (uint8_t i = 0; i < STATUS_LEDS_MAX_COUNT; i++)
     {
         expected_buffer[i].r = 0x00;
         expected_buffer[i].g = 0x00;
         expected_buffer[i].b = 0x00;
     }
-    expect_function_call(status_leds_hw_refresh);
+    // The strip already shows black (the fade is mocked), so nothing is sent
     expect_value(status_leds_hw_enable, enable, false);
 
     fade_animation_callback();
@@ -357,13 +502,207 @@ static void test_status_leds_toggle(void **state)
     will_return(board_mode_get, BOARD_MODE_IDLE);
     will_return(board_submode_get, BOARD_SUBMODE_IDLE_ACTIVE);
     will_return(footpads_get_state, NONE_FOOTPAD);
-    will_return(vesc_serial_get_battery_level, 90.0f);
+    will_return(vesc_serial_get_telemetry, &telemetry);
 
-    // Expect stop animation
-    expect_function_call(stop_animation);
-    expect_scan_animation();
+    // The battery gauge is drawn into its layer
+    expect_bar_fill();
 
     event_queue_call_mocked_callback(EVENT_COMMAND_TOGGLE_LIGHTS, &data);
+    expect_function_call(status_leds_hw_refresh);
+    status_leds_flush();
+}
+
+static void test_status_leds_layers(void **state)
+{
+    event_data_t data = {0};
+    vesc_telemetry_t telemetry = {0};
+    status_leds_color_t expected_buffer[STATUS_LEDS_MAX_COUNT] = {0};
+    status_leds_color_t white = {0xFF, 0xFF, 0xFF};
+
+    telemetry.battery_level = 900;
+
+    // Something is animating in the base layer
+    status_leds_set_color(&white, 0, STATUS_LEDS_MAX_COUNT - 1);
+    status_leds_refresh();
+    expect_function_call(status_leds_hw_refresh);
+    status_leds_flush();
+
+    // The battery gauge covers it (the mocked gauge draws nothing)
+    data.board_mode.mode = BOARD_MODE_IDLE;
+    data.board_mode.submode = BOARD_SUBMODE_IDLE_ACTIVE;
+    will_return(board_mode_get, BOARD_MODE_IDLE);
+    will_return(board_submode_get, BOARD_SUBMODE_IDLE_ACTIVE);
+    will_return(footpads_get_state, NONE_FOOTPAD);
+    will_return(vesc_serial_get_telemetry, &telemetry);
+    expect_crossfade();
+    expect_bar_fill();
+    event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
+    expect_function_call(status_leds_hw_refresh);
+    status_leds_flush();
+    validate_status_leds_buffer(expected_buffer, mock_status_leds_hw_get_buffer());
+
+    // A level change that stays in the drawn quarter LED neither redraws the
+    // gauge nor sends a frame, and neither does one just past its edge
+    telemetry.battery_level = 924;
+    will_return(board_mode_get, BOARD_MODE_IDLE);
+    will_return(board_submode_get, BOARD_SUBMODE_IDLE_ACTIVE);
+    will_return(footpads_get_state, NONE_FOOTPAD);
+    will_return(vesc_serial_get_telemetry, &telemetry);
+    send_battery_level_changed();
+    status_leds_flush();
+
+    telemetry.battery_level = 926;
+    will_return(board_mode_get, BOARD_MODE_IDLE);
+    will_return(board_submode_get, BOARD_SUBMODE_IDLE_ACTIVE);
+    will_return(footpads_get_state, NONE_FOOTPAD);
+    will_return(vesc_serial_get_telemetry, &telemetry);
+    send_battery_level_changed();
+    status_leds_flush();
+
+    // Moving well into the next quarter LED redraws it
+    telemetry.battery_level = 930;
+    will_return(board_mode_get, BOARD_MODE_IDLE);
+    will_return(board_submode_get, BOARD_SUBMODE_IDLE_ACTIVE);
+    will_return(footpads_get_state, NONE_FOOTPAD);
+    will_return(vesc_serial_get_telemetry, &telemetry);
+    expect_any(bar_fill, buffer);
+    expect_value(bar_fill, level, (37 * 64) - 256);
+    expect_any(bar_fill, color);
+    expect_function_call(bar_fill);
+    send_battery_level_changed();
+
+    // Changing mode hides the overlays and uncovers the base layer
+    settings->idle_animation = ANIMATION_OPTION_RAINBOW_MIRROR;
+    data.board_mode.submode = BOARD_SUBMODE_IDLE_DEFAULT;
+    will_return(board_mode_get, BOARD_MODE_IDLE);
+    will_return(board_submode_get, BOARD_SUBMODE_IDLE_DEFAULT);
+    expect_crossfade();
+    expect_fill_animation();
+    event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
+    expect_function_call(status_leds_hw_refresh);
+    status_leds_flush();
+    for (uint8_t i = 0; i < STATUS_LEDS_MAX_COUNT; i++)
+    {
+        expected_buffer[i] = white;
+    }
+    validate_status_leds_buffer(expected_buffer, mock_status_leds_hw_get_buffer());
+}
+
+/**
+ * @brief Test that the LED count follows the strips in the settings.
+ *
+ * @param state Unused parameter required by the cmocka framework.
+ */
+static void test_status_leds_chained_strips(void **state)
+{
+    event_data_t data = {0};
+    vesc_telemetry_t telemetry = {0};
+    status_leds_color_t expected_buffer[STATUS_LEDS_MAX_COUNT] = {0};
+    status_leds_color_t white = {0xFF, 0xFF, 0xFF};
+    status_leds_color_t red = {0xFF, 0x00, 0x00};
+    status_leds_color_t green = {0x00, 0xFF, 0x00};
+    status_leds_color_t blue = {0x00, 0x00, 0xFF};
+
+    assert_int_equal(8U, status_leds_get_count());
+
+    // Only the fitted LEDs can be drawn and sent
+    assert_int_equal(LCM_ERROR, status_leds_set_color(&white, 0, 8));
+    assert_int_equal(LCM_SUCCESS, status_leds_set_color(&white, 0, 7));
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        expected_buffer[i] = white;
+    }
+    status_leds_refresh();
+    expect_function_call(status_leds_hw_refresh);
+    status_leds_flush();
+    validate_status_leds_buffer(expected_buffer, mock_status_leds_hw_get_buffer());
+
+    // The personal color bands are split across the shorter strip
+    data.context = COMMAND_PROCESSOR_CONTEXT_PERSONAL_COLOR;
+    expect_any(fade_animation_setup, buffer);
+    expect_value(fade_animation_setup, period, STATUS_LEDS_FADE_TO_BLACK_TIMEOUT);
+    expect_not_value(fade_animation_setup, callback, NULL);
+    expect_function_call(fade_animation_setup);
+    will_return(fade_animation_setup, 1U);
+    event_queue_call_mocked_callback(EVENT_COMMAND_CONTEXT_CHANGED, &data);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        expected_buffer[i] = (i < 2) ? red : ((i < 6) ? green : blue);
+    }
+    status_leds_refresh();
+    expect_function_call(status_leds_hw_refresh);
+    status_leds_flush();
+    validate_status_leds_buffer(expected_buffer, mock_status_leds_hw_get_buffer());
+
+    // The battery gauge is scaled to the strip, 90% is 7.2 of 8 LEDs
+    telemetry.battery_level = 900;
+    data.board_mode.mode = BOARD_MODE_IDLE;
+    data.board_mode.submode = BOARD_SUBMODE_IDLE_ACTIVE;
+    will_return(board_mode_get, BOARD_MODE_IDLE);
+    will_return(board_submode_get, BOARD_SUBMODE_IDLE_ACTIVE);
+    will_return(footpads_get_state, NONE_FOOTPAD);
+    will_return(vesc_serial_get_telemetry, &telemetry);
+    expect_crossfade();
+    expect_any(bar_fill, buffer);
+    expect_value(bar_fill, level, (28 * 64) - 256);
+    expect_any(bar_fill, color);
+    expect_function_call(bar_fill);
+    event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
+
+    // Animations span both strips
+    settings->boot_animation = ANIMATION_OPTION_RAINBOW_MIRROR;
+    data.board_mode.mode = BOARD_MODE_BOOTING;
+    data.board_mode.submode = BOARD_SUBMODE_UNDEFINED;
+    will_return(board_mode_get, BOARD_MODE_BOOTING);
+    expect_crossfade();
+    expect_fill_animation();
+    event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
+
+    // Strips that do not fit the buffers are rejected
+    settings->status_leds_strips[1].count = STATUS_LEDS_MAX_COUNT;
+    assert_int_equal(0U, status_leds_strips_count(settings->status_leds_strips));
+}
+
+/**
+ * @brief Test that movement modulates the running animation without restarting it.
+ *
+ * @param state Unused parameter required by the cmocka framework.
+ */
+static void test_status_leds_modulation(void **state)
+{
+    event_data_t data = {0};
+    vesc_telemetry_t telemetry = {0};
+
+    // Start a scan, which follows the RPM
+    settings->boot_animation = ANIMATION_OPTION_RAINBOW_SCAN;
+    data.board_mode.mode = BOARD_MODE_BOOTING;
+    data.board_mode.submode = BOARD_SUBMODE_UNDEFINED;
+    will_return(board_mode_get, BOARD_MODE_BOOTING);
+    expect_crossfade();
+    expect_scan_animation();
+    event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
+
+    // Only the modulation level changes, in either direction
+    data.telemetry_changed = TELEMETRY_RPM;
+    telemetry.rpm = -STATUS_LEDS_MOD_RPM_FULL / 2;
+    will_return(vesc_serial_get_telemetry, &telemetry);
+    expect_value(animation_set_modulation, level, 127U);
+    expect_function_call(animation_set_modulation);
+    event_queue_call_mocked_callback(EVENT_TELEMETRY_UPDATED, &data);
+
+    telemetry.rpm = STATUS_LEDS_MOD_RPM_FULL * 3;
+    will_return(vesc_serial_get_telemetry, &telemetry);
+    expect_value(animation_set_modulation, level, 255U);
+    expect_function_call(animation_set_modulation);
+    event_queue_call_mocked_callback(EVENT_TELEMETRY_UPDATED, &data);
+
+    // Losing the VESC puts the modulation at rest
+    data.telemetry_changed = TELEMETRY_STALE;
+    telemetry.stale = true;
+    will_return(vesc_serial_get_telemetry, &telemetry);
+    expect_value(animation_set_modulation, level, 0U);
+    expect_function_call(animation_set_modulation);
+    event_queue_call_mocked_callback(EVENT_TELEMETRY_UPDATED, &data);
 }
 
 static void test_status_leds_idle_dozing(void **state)
@@ -377,6 +716,7 @@ static void test_status_leds_idle_dozing(void **state)
     // Disable dozing animation
     settings->dozing_animation = ANIMATION_OPTION_NONE;
 
+    expect_crossfade();
     // Expect a fade to black
     expect_any(fade_animation_setup, buffer);
     expect_value(fade_animation_setup, period, STATUS_LEDS_FADE_TO_BLACK_TIMEOUT);
@@ -389,28 +729,33 @@ static void test_status_leds_idle_dozing(void **state)
     // Status LEDs should stay off, even if battery changes
     will_return(board_mode_get, BOARD_MODE_IDLE);
     will_return(board_submode_get, BOARD_SUBMODE_IDLE_DOZING);
-    event_queue_call_mocked_callback(EVENT_BATTERY_LEVEL_CHANGED, &data);
+    send_battery_level_changed();
 
     // Set dozing animation to rainbow (fill animation)
     settings->dozing_animation = ANIMATION_OPTION_RAINBOW_MIRROR;
     will_return(board_mode_get, BOARD_MODE_IDLE);
     will_return(board_submode_get, BOARD_SUBMODE_IDLE_DOZING);
+    expect_crossfade();
     expect_fill_animation();
     event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
 
     // Animation keeps running, even if battery changes
     will_return(board_mode_get, BOARD_MODE_IDLE);
     will_return(board_submode_get, BOARD_SUBMODE_IDLE_DOZING);
-    event_queue_call_mocked_callback(EVENT_BATTERY_LEVEL_CHANGED, &data);
+    send_battery_level_changed();
 }
 
 const struct CMUnitTest status_leds_tests[] = {
     cmocka_unit_test_setup(test_status_leds_off, test_status_leds_setup),
     cmocka_unit_test_setup(test_status_leds_set_color, test_status_leds_setup),
+    cmocka_unit_test_setup(test_status_leds_refresh_coalesced, test_status_leds_setup),
     cmocka_unit_test_setup(test_status_leds_boot, test_status_leds_setup),
     cmocka_unit_test_setup(test_status_leds_fault, test_status_leds_setup),
     cmocka_unit_test_setup(test_status_leds_toggle, test_status_leds_setup),
+    cmocka_unit_test_setup(test_status_leds_layers, test_status_leds_setup),
     cmocka_unit_test_setup(test_status_leds_idle_dozing, test_status_leds_setup),
+    cmocka_unit_test_setup(test_status_leds_chained_strips, test_status_leds_chained_setup),
+    cmocka_unit_test_setup(test_status_leds_modulation, test_status_leds_setup),
 };
 
 #endif // TEST_STATUS_LEDS_H
@@ -25,6 +25,58 @@
 #include <stddef.h>
 
 #include "vesc_serial.h"
+#include "vesc_serial_internal.h"
+#include "crc16_ccitt.h"
+#include "mock_event_queue.h"
+
+/**
+ * @brief Frames a payload and pushes it into the RX ring buffer
+ *
+ * @param rx_buffer The ring buffer to push the packet into
+ * @param payload The payload, starting with the command ID
+ * @param length The length of the payload
+ */
+static void push_packet(ring_buffer_t *rx_buffer, const uint8_t *payload, uint8_t length)
+{
+    uint16_t crc = crc16_ccitt(payload, length);
+
+    ring_buffer_push(rx_buffer, 0x02);
+    ring_buffer_push(rx_buffer, length);
+    for (uint8_t i = 0; i < length; i++)
+    {
+        ring_buffer_push(rx_buffer, payload[i]);
+    }
+    ring_buffer_push(rx_buffer, (uint8_t)(crc >> 8));
+    ring_buffer_push(rx_buffer, (uint8_t)(crc & 0xff));
+    ring_buffer_push(rx_buffer, 0x03);
+}
+
+/**
+ * @brief Builds a COMM_GET_VALUES_SETUP_SELECTIVE response payload
+ *
+ * @param payload Buffer of at least 16 bytes
+ * @param duty_cycle Duty cycle in 0.1% units
+ * @param rpm Electrical RPM
+ * @param battery_level Battery level in 0.1% units
+ */
+static void build_values_payload(uint8_t *payload, int16_t duty_cycle, int32_t rpm,
+                                 int16_t battery_level)
+{
+    memset(payload, 0, 16);
+    payload[0] = 0x33;
+    payload[1] = 0x00;
+    payload[2] = 0x01;
+    payload[3] = 0x01;
+    payload[4] = 0xb0;
+    payload[5] = (uint8_t)(duty_cycle >> 8);
+    payload[6] = (uint8_t)(duty_cycle & 0xff);
+    payload[7] = (uint8_t)(rpm >> 24);
+    payload[8] = (uint8_t)(rpm >> 16);
+    payload[9] = (uint8_t)(rpm >> 8);
+    payload[10] = (uint8_t)(rpm & 0xff);
+    payload[13] = (uint8_t)(battery_level >> 8);
+    payload[14] = (uint8_t)(battery_level & 0xff);
+}
 
 int vesc_serial_setup(void **state)
 {
@@ -315,6 +367,281 @@ void test_vesc_serial_comm_setup_wrong_size(void **state)
     event_queue_call_mocked_callback(EVENT_SERIAL_DATA_RX, &data);
 }
 
+void test_vesc_serial_values_deadband(void **state)
+{
+    (void)state; // Unused
+    ring_buffer_t *rx_buffer = vesc_serial_get_rx_buffer();
+    event_data_t data = {0};
+    uint8_t payload[16];
+
+    // First packet: every field moves away from zero
+    build_values_payload(payload, 100, 1000, 500);
+    push_packet(rx_buffer, payload, sizeof(payload));
+
+    expect_value(event_queue_push, event, EVENT_VESC_ALIVE);
+    expect_any(event_queue_push, data);
+    expect_value(event_queue_push, event, EVENT_TELEMETRY_UPDATED);
+    expect_check(event_queue_push, data, validate_telemetry_changed,
+                 TELEMETRY_DUTY_CYCLE | TELEMETRY_RPM | TELEMETRY_BATTERY_LEVEL);
+    event_queue_call_mocked_callback(EVENT_SERIAL_DATA_RX, &data);
+    assert_int_equal(vesc_serial_get_telemetry()->sequence, 1);
+
+    // Jitter inside the deadbands should not raise any events
+    build_values_payload(payload, 102, 1003, 502);
+    push_packet(rx_buffer, payload, sizeof(payload));
+    event_queue_call_mocked_callback(EVENT_SERIAL_DATA_RX, &data);
+    assert_int_equal(vesc_serial_get_telemetry()->sequence, 2);
+
+    // Only the duty cycle moves far enough to be reported
+    build_values_payload(payload, 105, 1004, 504);
+    push_packet(rx_buffer, payload, sizeof(payload));
+    expect_value(event_queue_push, event, EVENT_TELEMETRY_UPDATED);
+    expect_check(event_queue_push, data, validate_telemetry_changed, TELEMETRY_DUTY_CYCLE);
+    event_queue_call_mocked_callback(EVENT_SERIAL_DATA_RX, &data);
+
+    const vesc_telemetry_t *telemetry = vesc_serial_get_telemetry();
+    assert_int_equal(telemetry->duty_cycle, 105);
+    assert_int_equal(telemetry->rpm, 1000);
+    assert_int_equal(telemetry->battery_level, 500);
+
+    // Slow down to a crawl
+    build_values_payload(payload, 105, 3, 504);
+    push_packet(rx_buffer, payload, sizeof(payload));
+    expect_value(event_queue_push, event, EVENT_TELEMETRY_UPDATED);
+    expect_check(event_queue_push, data, validate_telemetry_changed, TELEMETRY_RPM);
+    event_queue_call_mocked_callback(EVENT_SERIAL_DATA_RX, &data);
+
+    // Coming to a stop is always reported, even from inside the deadband
+    build_values_payload(payload, 105, 0, 504);
+    push_packet(rx_buffer, payload, sizeof(payload));
+    expect_value(event_queue_push, event, EVENT_TELEMETRY_UPDATED);
+    expect_check(event_queue_push, data, validate_telemetry_changed, TELEMETRY_RPM);
+    event_queue_call_mocked_callback(EVENT_SERIAL_DATA_RX, &data);
+    assert_int_equal(telemetry->rpm, 0);
+}
+
+void test_vesc_serial_single_update_event(void **state)
+{
+    (void)state; // Unused
+    ring_buffer_t *rx_buffer = vesc_serial_get_rx_buffer();
+    event_data_t data = {0};
+    uint8_t payload[16];
+
+    // Two responses arriving together are reported with a single event
+    build_values_payload(payload, 100, 1000, 500);
+    push_packet(rx_buffer, payload, sizeof(payload));
+    build_values_payload(payload, 100, 1000, 400);
+    payload[15] = 1U;
+    push_packet(rx_buffer, payload, sizeof(payload));
+
+    expect_value(event_queue_push, event, EVENT_VESC_ALIVE);
+    expect_any(event_queue_push, data);
+    expect_value(event_queue_push, event, EVENT_TELEMETRY_UPDATED);
+    expect_check(event_queue_push, data, validate_telemetry_changed,
+                 TELEMETRY_DUTY_CYCLE | TELEMETRY_RPM | TELEMETRY_BATTERY_LEVEL |
+                     TELEMETRY_FAULT);
+    event_queue_call_mocked_callback(EVENT_SERIAL_DATA_RX, &data);
+
+    const vesc_telemetry_t *telemetry = vesc_serial_get_telemetry();
+    assert_int_equal(telemetry->sequence, 2);
+    assert_int_equal(telemetry->battery_level, 400);
+    assert_int_equal(telemetry->fault, 1);
+    assert_true(ring_buffer_is_empty(rx_buffer));
+}
+
+void test_vesc_serial_reconnect(void **state)
+{
+    (void)state; // Unused
+    ring_buffer_t *rx_buffer = vesc_serial_get_rx_buffer();
+    event_data_t data = {0};
+    uint8_t payload[16];
+
+    // Start polling and hear from the VESC
+    expect_any(set_timer, timeout);
+    expect_any(set_timer, callback);
+    expect_value(set_timer, repeat, true);
+    data.board_mode.mode = BOARD_MODE_BOOTING;
+    event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
+
+    build_values_payload(payload, 100, 1000, 500);
+    push_packet(rx_buffer, payload, sizeof(payload));
+    expect_value(event_queue_push, event, EVENT_VESC_ALIVE);
+    expect_any(event_queue_push, data);
+    expect_value(event_queue_push, event, EVENT_TELEMETRY_UPDATED);
+    expect_check(event_queue_push, data, validate_telemetry_changed,
+                 TELEMETRY_DUTY_CYCLE | TELEMETRY_RPM | TELEMETRY_BATTERY_LEVEL);
+    event_queue_call_mocked_callback(EVENT_SERIAL_DATA_RX, &data);
+
+    // The VESC stops answering
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        expect_any(vesc_serial_hw_send, data);
+        expect_any(vesc_serial_hw_send, len);
+        call_timer_callback(1, 0);
+    }
+
+    // The timeout keeps the last values, marks them stale and starts probing
+    expect_value(fault, fault, EMERGENCY_FAULT_VESC_COMM_TIMEOUT);
+    expect_value(event_queue_push, event, EVENT_TELEMETRY_UPDATED);
+    expect_check(event_queue_push, data, validate_telemetry_changed, TELEMETRY_STALE);
+    expect_value(set_timer, timeout, 10U);
+    expect_any(set_timer, callback);
+    expect_value(set_timer, repeat, true);
+    expect_any(vesc_serial_hw_send, data);
+    expect_any(vesc_serial_hw_send, len);
+    call_timer_callback(1, 0);
+
+    const vesc_telemetry_t *telemetry = vesc_serial_get_telemetry();
+    assert_true(telemetry->stale);
+    assert_int_equal(telemetry->rpm, 1000);
+
+    // A few fast probes, then back off
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        expect_any(vesc_serial_hw_send, data);
+        expect_any(vesc_serial_hw_send, len);
+        call_timer_callback(1, 0);
+    }
+
+    expect_value(set_timer, timeout, 20U);
+    expect_any(set_timer, callback);
+    expect_value(set_timer, repeat, true);
+    expect_any(vesc_serial_hw_send, data);
+    expect_any(vesc_serial_hw_send, len);
+    call_timer_callback(1, 0);
+
+    expect_value(set_timer, timeout, 40U);
+    expect_any(set_timer, callback);
+    expect_value(set_timer, repeat, true);
+    expect_any(vesc_serial_hw_send, data);
+    expect_any(vesc_serial_hw_send, len);
+    call_timer_callback(1, 0);
+
+    // The VESC answers again, so normal polling resumes with live values
+    push_packet(rx_buffer, payload, sizeof(payload));
+    expect_value(event_queue_push, event, EVENT_VESC_ALIVE);
+    expect_any(event_queue_push, data);
+    expect_any(set_timer, timeout);
+    expect_any(set_timer, callback);
+    expect_value(set_timer, repeat, true);
+    expect_value(event_queue_push, event, EVENT_TELEMETRY_UPDATED);
+    expect_check(event_queue_push, data, validate_telemetry_changed, TELEMETRY_STALE);
+    event_queue_call_mocked_callback(EVENT_SERIAL_DATA_RX, &data);
+    assert_false(telemetry->stale);
+}
+
+#ifdef ENABLE_IMU_EVENTS
+/**
+ * @brief Writes a float into a buffer in VESC (big endian) byte order
+ */
+static void put_float32(uint8_t *buffer, float value)
+{
+    union { uint32_t i; float f; } u;
+    u.f = value;
+    buffer[0] = (uint8_t)(u.i >> 24);
+    buffer[1] = (uint8_t)(u.i >> 16);
+    buffer[2] = (uint8_t)(u.i >> 8);
+    buffer[3] = (uint8_t)(u.i & 0xff);
+}
+
+void test_vesc_serial_imu_deadband(void **state)
+{
+    (void)state; // Unused
+    ring_buffer_t *rx_buffer = vesc_serial_get_rx_buffer();
+    event_data_t data = {0};
+    uint8_t payload[12] = {0x41, 0x00, 0x03};
+
+    // Pitch of 0.5 radians is reported in centidegrees
+    put_float32(&payload[3], 0.0f);
+    put_float32(&payload[7], 0.5f);
+    push_packet(rx_buffer, payload, sizeof(payload));
+
+    expect_value(event_queue_push, event, EVENT_VESC_ALIVE);
+    expect_any(event_queue_push, data);
+    expect_value(event_queue_push, event, EVENT_TELEMETRY_UPDATED);
+    expect_check(event_queue_push, data, validate_telemetry_changed, TELEMETRY_IMU_PITCH);
+    event_queue_call_mocked_callback(EVENT_SERIAL_DATA_RX, &data);
+    assert_int_equal(vesc_serial_get_telemetry()->imu_pitch, 2864);
+
+    // The same reading (converted to centidegrees) must not be reported again
+    push_packet(rx_buffer, payload, sizeof(payload));
+    event_queue_call_mocked_callback(EVENT_SERIAL_DATA_RX, &data);
+
+    // A fraction of a degree is inside the deadband
+    put_float32(&payload[7], 0.505f);
+    push_packet(rx_buffer, payload, sizeof(payload));
+    event_queue_call_mocked_callback(EVENT_SERIAL_DATA_RX, &data);
+    assert_int_equal(vesc_serial_get_telemetry()->imu_pitch, 2864);
+}
+
+void test_vesc_serial_radians_to_centidegrees(void **state)
+{
+    (void)state; // Unused
+    uint8_t buffer[4];
+
+    put_float32(buffer, 0.0f);
+    assert_int_equal(buffer_get_radians_as_centidegrees(buffer), 0);
+
+    put_float32(buffer, -0.0f);
+    assert_int_equal(buffer_get_radians_as_centidegrees(buffer), 0);
+
+    // Within one count of the exact conversion across the full range
+    const float angles[] = {1e-6f, 0.01f, 0.5f, -0.7854f, 1.5708f, -3.14159f};
+    for (size_t i = 0; i < sizeof(angles) / sizeof(angles[0]); i++)
+    {
+        put_float32(buffer, angles[i]);
+        int32_t expected = (int32_t)(angles[i] * 18000.0f / 3.14159265f);
+        assert_in_range(buffer_get_radians_as_centidegrees(buffer), expected - 1, expected + 1);
+    }
+
+    // Nonsense values saturate rather than wrap
+    put_float32(buffer, 1e9f);
+    assert_int_equal(buffer_get_radians_as_centidegrees(buffer), INT16_MAX);
+    put_float32(buffer, -1e9f);
+    assert_int_equal(buffer_get_radians_as_centidegrees(buffer), -INT16_MAX);
+}
+
+void test_vesc_serial_imu_demand(void **state)
+{
+    (void)state; // Unused
+    event_data_t data = {0};
+
+    // Something needs the roll, but only while idle
+    vesc_serial_declare_demand(TELEMETRY_IMU_ROLL, BOARD_MODE_MASK(BOARD_MODE_IDLE));
+
+    // Booting only polls the basic values
+    expect_any(set_timer, timeout);
+    expect_any(set_timer, callback);
+    expect_value(set_timer, repeat, true);
+    data.board_mode.mode = BOARD_MODE_BOOTING;
+    event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
+
+    expect_any(vesc_serial_hw_send, data);
+    expect_value(vesc_serial_hw_send, len, 10U);
+    call_timer_callback(1, 0);
+
+    // Idle adds the IMU request
+    expect_any(is_timer_active, timer_id);
+    will_return(is_timer_active, true);
+    data.board_mode.mode = BOARD_MODE_IDLE;
+    event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
+
+    expect_any(vesc_serial_hw_send, data);
+    expect_value(vesc_serial_hw_send, len, 18U);
+    call_timer_callback(1, 0);
+
+    // Riding drops it again
+    expect_any(is_timer_active, timer_id);
+    will_return(is_timer_active, true);
+    data.board_mode.mode = BOARD_MODE_RIDING;
+    event_queue_call_mocked_callback(EVENT_BOARD_MODE_CHANGED, &data);
+
+    expect_any(vesc_serial_hw_send, data);
+    expect_value(vesc_serial_hw_send, len, 10U);
+    call_timer_callback(1, 0);
+}
+#endif
+
 const struct CMUnitTest vesc_serial_tests[] = {
     cmocka_unit_test_setup(test_vesc_serial_timer, vesc_serial_setup),
     cmocka_unit_test_setup(test_vesc_serial_timer_callback, vesc_serial_setup),
@@ -327,6 +654,14 @@ const struct CMUnitTest vesc_serial_tests[] = {
     cmocka_unit_test_setup(test_vesc_serial_crc_invalid, vesc_serial_setup),
     cmocka_unit_test_setup(test_vesc_serial_unknown_command, vesc_serial_setup),
     cmocka_unit_test_setup(test_vesc_serial_comm_setup_wrong_size, vesc_serial_setup),
+    cmocka_unit_test_setup(test_vesc_serial_values_deadband, vesc_serial_setup),
+    cmocka_unit_test_setup(test_vesc_serial_single_update_event, vesc_serial_setup),
+    cmocka_unit_test_setup(test_vesc_serial_reconnect, vesc_serial_setup),
+#ifdef ENABLE_IMU_EVENTS
+    cmocka_unit_test_setup(test_vesc_serial_imu_deadband, vesc_serial_setup),
+    cmocka_unit_test(test_vesc_serial_radians_to_centidegrees),
+    cmocka_unit_test_setup(test_vesc_serial_imu_demand, vesc_serial_setup),
+#endif
 };
 
 #endif
\ No newline at end of file